@@ -211,6 +211,7 @@ int main(int argc, const char* argv[])
 		LibSm64Config resourceConfig;
 		resourceConfig.dllPath = path;
 		resourceConfig.lightweight = true;
+		resourceConfig.checkpointCacheDirectory = std::filesystem::path("C:/repos/sm64-tas-scripting/cache/");
 		resourceConfig.countryCode = CountryCode::SUPER_MARIO_64_J;
 
 		resources.emplace_back(resourceConfig);
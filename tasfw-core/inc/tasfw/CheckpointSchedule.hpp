@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#ifndef CHECKPOINT_SCHEDULE_H
+#define CHECKPOINT_SCHEDULE_H
+
+/// <summary>
+/// Binomial (revolve-style) checkpoint placement for scripts that revisit a frame range in reverse order.
+/// Given a number of free checkpoints, chooses where to save while advancing so that replay frames are minimized.
+/// </summary>
+class CheckpointSchedule
+{
+public:
+	// Number of frames that can be revisited in reverse with the given checkpoints (including the starting one)
+	// and number of replays per frame, i.e. binomial(nCheckpoints + nReplays, nCheckpoints). Saturates instead of overflowing.
+	static int64_t Beta(int64_t nCheckpoints, int64_t nReplays);
+
+	// Frames to checkpoint while advancing from startFrame (which already has a save) to endFrame.
+	// Frames are returned in ascending order and are strictly between startFrame and endFrame.
+	static std::vector<int64_t> GetCheckpointFrames(int64_t startFrame, int64_t endFrame, int64_t nFreeCheckpoints);
+};
+
+#endif
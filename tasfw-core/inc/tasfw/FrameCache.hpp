@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+/// <summary>
+/// Frame-indexed cache whose suffix can be invalidated in O(1).
+/// Entries are stamped with the epoch they were written in. Invalidating bumps the epoch and records the first stale frame,
+/// stale entries are ignored on read, and they are erased in bulk once enough invalidations pile up or a read runs into one.
+/// </summary>
+template <typename TValue>
+class FrameCache
+{
+public:
+	FrameCache() = default;
+
+	FrameCache(const FrameCache<TValue>&) = delete;
+	FrameCache<TValue>& operator= (const FrameCache<TValue>&) = delete;
+
+	FrameCache(FrameCache<TValue>&&) = default;
+	FrameCache<TValue>& operator= (FrameCache<TValue>&&) = default;
+
+	bool Contains(int64_t frame);
+
+	// Returns nullptr if there is no current entry on this frame
+	TValue* Find(int64_t frame);
+
+	// Frame of the latest current entry at or before frame, or -1 if there is none
+	int64_t GetLatestFrame(int64_t frame);
+
+	// Current entry on this frame, value-initialized if missing or stale
+	TValue& operator[](int64_t frame);
+
+	// Constructs an entry in place unless a current one already exists. Returns whether an entry was constructed.
+	template <typename... Us>
+	bool Emplace(int64_t frame, Us&&... params);
+
+	void Erase(int64_t frame);
+
+	// Mark all entries at or after firstFrame stale
+	void Invalidate(int64_t firstFrame);
+
+	// Transfer current entries at or before lastFrame that dest does not already have. Entries are moved, not copied.
+	void MoveInto(FrameCache<TValue>& dest, int64_t lastFrame);
+
+	// Erase all stale entries at once
+	void Reclaim();
+
+	void Clear();
+
+private:
+	class Entry
+	{
+	public:
+		TValue value;
+		uint64_t epoch = 0;
+
+		template <typename... Us>
+		Entry(uint64_t epoch, Us&&... params) : value(std::forward<Us>(params)...), epoch(epoch) {}
+	};
+
+	class Invalidation
+	{
+	public:
+		uint64_t epoch = 0;
+		int64_t firstFrame = 0;
+	};
+
+	// Number of pending invalidations that triggers a reclaim
+	static constexpr uint64_t maxPendingInvalidations = 32;
+
+	std::map<int64_t, Entry> entries;
+
+	// Pending invalidations, with both epoch and first frame strictly increasing. A later invalidation at an earlier frame
+	// covers every entry an earlier one would, so those are dropped when it is recorded.
+	std::vector<Invalidation> invalidations;
+	uint64_t epoch = 0;
+	bool writtenSinceInvalidation = false;
+
+	bool IsStale(int64_t frame, const Entry& entry) const;
+};
+
+//Include template method implementations
+#include "tasfw/FrameCache.t.hpp"
+
+#endif
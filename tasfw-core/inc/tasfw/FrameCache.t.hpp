@@ -0,0 +1,167 @@
+#pragma once
+#ifndef FRAME_CACHE_H
+#error "FrameCache.t.hpp should only be included by FrameCache.hpp"
+#else
+
+#include <algorithm>
+
+template <typename TValue>
+bool FrameCache<TValue>::Contains(int64_t frame)
+{
+	return Find(frame) != nullptr;
+}
+
+template <typename TValue>
+TValue* FrameCache<TValue>::Find(int64_t frame)
+{
+	auto entry = entries.find(frame);
+	if (entry == entries.end() || IsStale(entry->first, entry->second))
+		return nullptr;
+
+	return &entry->second.value;
+}
+
+template <typename TValue>
+int64_t FrameCache<TValue>::GetLatestFrame(int64_t frame)
+{
+	auto entry = entries.upper_bound(frame);
+	while (entry != entries.begin())
+	{
+		entry = std::prev(entry);
+		if (!IsStale(entry->first, entry->second))
+			return entry->first;
+
+		// Rather than stepping over stale entries one at a time, clear them all out and search again
+		Reclaim();
+		entry = entries.upper_bound(frame);
+	}
+
+	return -1;
+}
+
+template <typename TValue>
+TValue& FrameCache<TValue>::operator[](int64_t frame)
+{
+	writtenSinceInvalidation = true;
+
+	auto entry = entries.find(frame);
+	if (entry == entries.end())
+		return entries.try_emplace(frame, epoch).first->second.value;
+
+	if (IsStale(entry->first, entry->second))
+		entry->second.value = TValue();
+
+	entry->second.epoch = epoch;
+	return entry->second.value;
+}
+
+template <typename TValue>
+template <typename... Us>
+bool FrameCache<TValue>::Emplace(int64_t frame, Us&&... params)
+{
+	auto entry = entries.find(frame);
+	if (entry != entries.end())
+	{
+		if (!IsStale(entry->first, entry->second))
+			return false;
+
+		entries.erase(entry);
+	}
+
+	entries.emplace(std::piecewise_construct, std::forward_as_tuple(frame), std::forward_as_tuple(epoch, std::forward<Us>(params)...));
+	writtenSinceInvalidation = true;
+	return true;
+}
+
+template <typename TValue>
+void FrameCache<TValue>::Erase(int64_t frame)
+{
+	entries.erase(frame);
+}
+
+template <typename TValue>
+void FrameCache<TValue>::Invalidate(int64_t firstFrame)
+{
+	// Nothing to do if no entry lies at or beyond the first frame, which is the common case when writing at the end of the cache
+	if (entries.empty() || entries.rbegin()->first < firstFrame)
+		return;
+
+	// Also nothing to do if an earlier invalidation already covers this one and nothing has been written since
+	if (!writtenSinceInvalidation && !invalidations.empty() && invalidations.back().firstFrame <= firstFrame)
+		return;
+
+	epoch++;
+	while (!invalidations.empty() && invalidations.back().firstFrame >= firstFrame)
+		invalidations.pop_back();
+
+	invalidations.push_back(Invalidation{ epoch, firstFrame });
+	writtenSinceInvalidation = false;
+
+	if (invalidations.size() >= maxPendingInvalidations)
+		Reclaim();
+}
+
+template <typename TValue>
+void FrameCache<TValue>::MoveInto(FrameCache<TValue>& dest, int64_t lastFrame)
+{
+	auto entry = entries.begin();
+	while (entry != entries.end() && entry->first <= lastFrame)
+	{
+		auto nextEntry = std::next(entry);
+		if (!IsStale(entry->first, entry->second))
+		{
+			auto destEntry = dest.entries.find(entry->first);
+			if (destEntry == dest.entries.end() || dest.IsStale(destEntry->first, destEntry->second))
+			{
+				if (destEntry != dest.entries.end())
+					dest.entries.erase(destEntry);
+
+				// Transfer the node itself so that the value is never copied or left behind in a moved-from state
+				auto node = entries.extract(entry);
+				node.mapped().epoch = dest.epoch;
+				dest.entries.insert(std::move(node));
+				dest.writtenSinceInvalidation = true;
+			}
+		}
+
+		entry = nextEntry;
+	}
+}
+
+template <typename TValue>
+void FrameCache<TValue>::Reclaim()
+{
+	if (invalidations.empty())
+		return;
+
+	// No entry before the earliest invalidated frame can be stale
+	auto entry = entries.lower_bound(invalidations.front().firstFrame);
+	while (entry != entries.end())
+	{
+		if (IsStale(entry->first, entry->second))
+			entry = entries.erase(entry);
+		else
+			entry++;
+	}
+
+	invalidations.clear();
+}
+
+template <typename TValue>
+void FrameCache<TValue>::Clear()
+{
+	entries.clear();
+	invalidations.clear();
+}
+
+template <typename TValue>
+bool FrameCache<TValue>::IsStale(int64_t frame, const Entry& entry) const
+{
+	// The earliest invalidation after the entry was written also has the lowest first frame of all of them
+	auto invalidation = std::upper_bound(invalidations.begin(), invalidations.end(), entry.epoch,
+		[](uint64_t entryEpoch, const Invalidation& invalidation) { return entryEpoch < invalidation.epoch; });
+
+	return invalidation != invalidations.end() && frame >= invalidation->firstFrame;
+}
+
+#endif
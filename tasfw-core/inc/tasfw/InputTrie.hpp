@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <tasfw/Inputs.hpp>
+
+#ifndef INPUT_TRIE_H
+#define INPUT_TRIE_H
+
+/// <summary>
+/// Prefix tree of per-frame input sequences starting from a common frame.
+/// Used to evaluate many input candidates while advancing each shared prefix only once.
+/// </summary>
+class InputTrie
+{
+public:
+	class Node
+	{
+	public:
+		Inputs inputs; // Inputs written on the frame leading into this node. Unused for root.
+		int64_t frame = -1; // Frame the state is on once this node is reached
+		std::vector<int64_t> children;
+		std::vector<int64_t> candidates; // Candidates whose inputs end on this node
+
+		Node() = default;
+		Node(Inputs inputs, int64_t frame) : inputs(inputs), frame(frame) {}
+	};
+
+	int64_t startFrame = 0;
+	std::vector<Node> nodes; // nodes[0] is the root, i.e. the state at startFrame
+
+	InputTrie(int64_t startFrame);
+
+	void Insert(int64_t candidate, const std::vector<Inputs>& inputs);
+
+	// True if the state at this node will be needed again after descending into a child
+	bool IsBranchPoint(int64_t node) const;
+};
+
+#endif
@@ -9,6 +9,9 @@
 
 #include <cstdlib>
 #include <chrono>
+#include <fstream>
+#include <map>
+#include <unordered_set>
 
 //#include <tasfw/Script.hpp>
 
@@ -50,6 +53,13 @@ public:
 	bool isValid(int64_t slotId);
 };
 
+enum class CachedCheckpointLoad
+{
+	Loaded,
+	Unreadable, // The current state is untouched
+	WrongFrame // The loaded state is not on the expected frame, so the current state has to be restored
+};
+
 // Interface for the state machine that represents the game. Can either contain the state machine itself, or be a client to an external state machine.
 template <class TState>
 class Resource
@@ -65,6 +75,10 @@ public:
 	TState startSave = TState();
 	int64_t initialFrame = -1;
 	SlotManager<TState> slotManager = SlotManager<TState>(this);
+	std::filesystem::path checkpointCacheDirectory; // if set, long loads from power-on are cached on disk
+
+	// Whether a state saved by one instance can be loaded into another. Not if states hold pointers into their own instance, like LibSm64's.
+	static constexpr bool RelocatableStates = false;
 
 	Resource() = default;
 
@@ -74,12 +88,22 @@ public:
 
 	int64_t SaveState();
 	void LoadState(int64_t slotId);
+	// Copy states out of and into the resource directly, e.g. to keep them in a cache outside of the slot manager
+	void SaveState(TState& state);
+	void LoadState(const TState& state);
 	void FrameAdvance();
 	bool shouldSave(int64_t framesSinceLastSave) const;
 	bool shouldLoad(int64_t framesAhead) const;
 	uint64_t GetTotalSaveStateTime();
 	uint64_t GetTotalLoadStateTime();
 	uint64_t GetTotalFrameAdvanceTime();
+	int64_t GetSaveMemLimit() const;
+	int64_t GetEstimatedStateSize() const;
+
+	bool IsCheckpointCacheEnabled() const;
+	int64_t FindCachedCheckpoint(const std::vector<uint64_t>& inputsHashes, int64_t minFrame, int64_t maxFrame) const;
+	CachedCheckpointLoad LoadCachedCheckpoint(int64_t frame, uint64_t inputsHash);
+	void SaveCachedCheckpoint(int64_t frame, uint64_t inputsHash);
 
 	//Return a conversion of the current state for the user to do with as they like (e.g. pass to a new top-level script)
 	//Requires a matching constructor in the return type that will convert TState to the return type
@@ -97,8 +121,36 @@ public:
 	virtual std::size_t getStateSize(const TState& state) const = 0;
 	//TODO: make this resource-agnostic
 	virtual uint32_t getCurrentFrame() const = 0;
+
+	// Optional, needed for the on-disk checkpoint cache. Build hash should change whenever saved states become incompatible,
+	// including when states hold pointers and the resource is loaded at a different address.
+	virtual uint64_t getBuildHash() const { return 0; }
+	virtual bool serialize(const TState&, std::ostream&) const { return false; }
+	virtual bool deserialize(TState&, std::istream&) const { return false; }
+
+private:
+	// Input hashes of the checkpoints in the cache directory, by frame. Built from one scan of the directory, then kept up to date
+	// with the checkpoints this resource writes.
+	mutable std::map<int64_t, std::unordered_set<uint64_t>> cachedCheckpoints;
+	mutable bool cachedCheckpointsIndexed = false;
+
+	std::filesystem::path GetCachedCheckpointPath(int64_t frame, uint64_t inputsHash) const;
+	void IndexCachedCheckpoints() const;
 };
 
+// FNV-1a, used to key cached checkpoints by their inputs and resource build
+static inline uint64_t HashBytes(const void* data, std::size_t size, uint64_t hash = 0xcbf29ce484222325)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+	for (std::size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3;
+	}
+
+	return hash;
+}
+
 //Include template method implementations
 #include "tasfw/Resource.t.hpp"
 
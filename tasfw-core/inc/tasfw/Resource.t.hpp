@@ -141,6 +141,26 @@ void Resource<TState>::LoadState(int64_t slotId)
 	nLoadStates++;
 }
 
+template <class TState>
+void Resource<TState>::SaveState(TState& state)
+{
+	auto start = get_time();
+	save(state);
+	_totalSaveStateTime += get_time() - start;
+
+	nSaveStates++;
+}
+
+template <class TState>
+void Resource<TState>::LoadState(const TState& state)
+{
+	uint64_t start = get_time();
+	load(state);
+	_totalLoadStateTime += get_time() - start;
+
+	nLoadStates++;
+}
+
 template <class TState>
 void Resource<TState>::FrameAdvance()
 {
@@ -169,6 +189,144 @@ uint64_t Resource<TState>::GetTotalFrameAdvanceTime()
 	return _totalFrameAdvanceTime;
 }
 
+template <class TState>
+int64_t Resource<TState>::GetSaveMemLimit() const
+{
+	return slotManager._saveMemLimit;
+}
+
+// Average size of the saves in the slot manager, or the start save's size if there are none
+template <class TState>
+int64_t Resource<TState>::GetEstimatedStateSize() const
+{
+	if (slotManager.slotsById.empty())
+		return getStateSize(startSave);
+
+	return slotManager._currentSaveMem / slotManager.slotsById.size();
+}
+
+template <class TState>
+bool Resource<TState>::IsCheckpointCacheEnabled() const
+{
+	return !checkpointCacheDirectory.empty() && getBuildHash() != 0;
+}
+
+template <class TState>
+std::filesystem::path Resource<TState>::GetCachedCheckpointPath(int64_t frame, uint64_t inputsHash) const
+{
+	char fileName[64];
+	snprintf(fileName, sizeof(fileName), "%016llx_%lld_%016llx.state",
+		(unsigned long long)getBuildHash(), (long long)frame, (unsigned long long)inputsHash);
+
+	return checkpointCacheDirectory / fileName;
+}
+
+// Scan the cache directory for checkpoints of this build, once
+template <class TState>
+void Resource<TState>::IndexCachedCheckpoints() const
+{
+	if (cachedCheckpointsIndexed)
+		return;
+
+	cachedCheckpointsIndexed = true;
+
+	std::error_code error;
+	auto files = std::filesystem::directory_iterator(checkpointCacheDirectory, error);
+	for (; !error && files != std::filesystem::directory_iterator(); files.increment(error))
+	{
+		// Same name as GetCachedCheckpointPath. Temporary files from interrupted writes have a longer extension.
+		unsigned long long buildHash = 0;
+		long long frame = 0;
+		unsigned long long inputsHash = 0;
+		char extension[8] = "";
+		std::string fileName = files->path().filename().string();
+		if (sscanf(fileName.c_str(), "%16llx_%lld_%16llx%7s", &buildHash, &frame, &inputsHash, extension) == 4
+			&& strcmp(extension, ".state") == 0 && buildHash == getBuildHash())
+			cachedCheckpoints[frame].insert(inputsHash);
+	}
+}
+
+// Find the latest cached frame in [minFrame, maxFrame] that matches the inputs leading up to it, or -1 if there is none
+// inputsHashes[frame] is the hash of all inputs prior to that frame
+// Checkpoints written to the directory by other resources after it was first scanned are not found.
+template <class TState>
+int64_t Resource<TState>::FindCachedCheckpoint(const std::vector<uint64_t>& inputsHashes, int64_t minFrame, int64_t maxFrame) const
+{
+	if (!IsCheckpointCacheEnabled())
+		return -1;
+
+	IndexCachedCheckpoints();
+	for (auto checkpoint = cachedCheckpoints.upper_bound(maxFrame); checkpoint != cachedCheckpoints.begin();)
+	{
+		checkpoint--;
+		if (checkpoint->first < minFrame)
+			break;
+
+		if (checkpoint->second.contains(inputsHashes[checkpoint->first]))
+			return checkpoint->first;
+	}
+
+	return -1;
+}
+
+template <class TState>
+CachedCheckpointLoad Resource<TState>::LoadCachedCheckpoint(int64_t frame, uint64_t inputsHash)
+{
+	uint64_t start = get_time();
+
+	std::ifstream in(GetCachedCheckpointPath(frame, inputsHash), std::ios::binary);
+	if (!in)
+		return CachedCheckpointLoad::Unreadable;
+
+	TState state = TState();
+	if (!deserialize(state, in))
+		return CachedCheckpointLoad::Unreadable;
+
+	load(state);
+	_totalLoadStateTime += get_time() - start;
+
+	nLoadStates++;
+
+	return getCurrentFrame() == frame ? CachedCheckpointLoad::Loaded : CachedCheckpointLoad::WrongFrame;
+}
+
+template <class TState>
+void Resource<TState>::SaveCachedCheckpoint(int64_t frame, uint64_t inputsHash)
+{
+	if (!IsCheckpointCacheEnabled())
+		return;
+
+	IndexCachedCheckpoints();
+	if (cachedCheckpoints.contains(frame) && cachedCheckpoints[frame].contains(inputsHash))
+		return;
+
+	std::error_code error;
+	std::filesystem::path path = GetCachedCheckpointPath(frame, inputsHash);
+	std::filesystem::create_directories(checkpointCacheDirectory, error);
+
+	TState state = TState();
+	save(state);
+
+	// Write to a unique temporary file first so concurrent writers never expose a partial checkpoint
+	std::filesystem::path tempPath = path;
+	tempPath += "." + std::to_string(reinterpret_cast<uintptr_t>(this)) + ".tmp";
+	{
+		std::ofstream out(tempPath, std::ios::binary);
+		if (!out || !serialize(state, out))
+		{
+			out.close();
+			std::filesystem::remove(tempPath, error);
+			return;
+		}
+	}
+
+	std::filesystem::rename(tempPath, path, error);
+	if (error)
+		std::filesystem::remove(tempPath, error);
+	else
+		cachedCheckpoints[frame].insert(inputsHash);
+}
+
 template <class TState>
 bool Resource<TState>::shouldSave(int64_t estFrameAdvances) const
 {
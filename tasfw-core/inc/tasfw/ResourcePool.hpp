@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <tasfw/Resource.hpp>
+
+#ifndef RESOURCE_POOL_H
+#define RESOURCE_POOL_H
+
+/// <summary>
+/// Idle resources that parallel compare methods can evaluate candidates on, one worker thread per resource.
+/// Resources are either constructed and owned by the pool, or borrowed from the caller.
+/// Each resource should only be used by one parallel compare at a time.
+/// </summary>
+template <derived_from_specialization_of<Resource> TResource>
+class ResourcePool
+{
+public:
+	ResourcePool() = default;
+
+	ResourcePool(const ResourcePool<TResource>&) = delete;
+	ResourcePool<TResource>& operator= (const ResourcePool<TResource>&) = delete;
+
+	// Construct one resource per config
+	template <class TResourceConfig>
+		requires (std::constructible_from<TResource, const TResourceConfig&>)
+	ResourcePool(const std::vector<TResourceConfig>& resourceConfigs)
+	{
+		for (const TResourceConfig& resourceConfig : resourceConfigs)
+		{
+			ownedResources.push_back(std::make_unique<TResource>(resourceConfig));
+			resources.push_back(ownedResources.back().get());
+		}
+	}
+
+	// Borrow resources owned by the caller
+	ResourcePool(std::vector<TResource*> resources) : resources(std::move(resources)) {}
+
+	int64_t Size() const { return resources.size(); }
+
+	TResource* Get(int64_t index) const
+	{
+		if (index < 0 || index >= Size())
+			throw std::runtime_error("Resource pool index out of range");
+
+		return resources[index];
+	}
+
+private:
+	std::vector<std::unique_ptr<TResource>> ownedResources;
+	std::vector<TResource*> resources;
+};
+
+#endif
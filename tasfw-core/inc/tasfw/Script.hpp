@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <unordered_map>
 #include <tasfw/Resource.hpp>
 #include <tasfw/Inputs.hpp>
@@ -7,6 +8,12 @@
 #include <set>
 #include <tasfw/SharedLib.hpp>
 #include <tasfw/ScriptCompareHelper.hpp>
+#include <tasfw/CheckpointSchedule.hpp>
+#include <tasfw/FrameCache.hpp>
+#include <tasfw/TrackedStateBuffer.hpp>
+#include <tasfw/ScriptProfiler.hpp>
+#include <tasfw/ScriptBudget.hpp>
+#include <optional>
 
 #ifndef SCRIPT_H
 #define SCRIPT_H
@@ -38,6 +45,17 @@ class StateTrackerFactoryBase;
 template <derived_from_specialization_of<Resource> TResource>
 class ScriptFriend;
 
+// State trackers that can compute a frame's state from the previous frame's state, given the resource is already on that frame.
+// These are kept up to date as scripts advance frames instead of being re-simulated on demand.
+// HasPreviousState is false on frames whose state doesn't build on the previous frame's, e.g. the tracker's first frame.
+// advance must leave the frame and inputs as it found them, so any simulation it needs goes in ExecuteAdhoc.
+template <typename TStateTracker>
+concept StreamingStateTracker = requires (TStateTracker& stateTracker, const typename TStateTracker::CustomScriptStatus& previousState)
+{
+	{ stateTracker.advance(previousState) } -> std::same_as<bool>;
+	{ stateTracker.HasPreviousState() } -> std::same_as<bool>;
+};
+
 template <derived_from_specialization_of<Resource> TResource>
 class SlotHandle
 {
@@ -152,6 +170,7 @@ protected:
 		BaseStatus[_adhocLevel].nLoads += script.BaseStatus[0].nLoads;
 		BaseStatus[_adhocLevel].nSaves += script.BaseStatus[0].nSaves;
 		BaseStatus[_adhocLevel].nFrameAdvances += script.BaseStatus[0].nFrameAdvances;
+		BaseStatus[_adhocLevel].nAborts += script.BaseStatus[0].nAborts;
 
 		return ScriptStatus<TScript>(script.BaseStatus[0], script.CustomStatus);
 	}
@@ -184,6 +203,7 @@ protected:
 		BaseStatus[_adhocLevel].nLoads += script.BaseStatus[0].nLoads;
 		BaseStatus[_adhocLevel].nSaves += script.BaseStatus[0].nSaves;
 		BaseStatus[_adhocLevel].nFrameAdvances += script.BaseStatus[0].nFrameAdvances;
+		BaseStatus[_adhocLevel].nAborts += script.BaseStatus[0].nAborts;
 
 		return ScriptStatus<TScript>(script.BaseStatus[0], script.CustomStatus);
 	}
@@ -197,6 +217,34 @@ protected:
 		return status;
 	}
 
+	// Best status so far of the compare this script is a candidate in, or nullptr if there is none yet.
+	// Candidates can compare their partial results against it and Abort once they can no longer win.
+	// Also finds the incumbent of adhoc compares over StatusField<TScript>.
+	template <derived_from_specialization_of<Script> TScript>
+	const ScriptStatus<TScript>* GetIncumbent()
+	{
+		if (!_parentScript)
+			return nullptr;
+
+		auto incumbent = _parentScript->compareHelper.template GetIncumbent<ScriptStatus<TScript>>();
+		if (incumbent)
+			return incumbent;
+
+		auto fieldIncumbent = _parentScript->compareHelper.template GetIncumbent<AdhocScriptStatus<StatusField<TScript>>>();
+		return fieldIncumbent ? &fieldIncumbent->status : nullptr;
+	}
+
+	// Best status so far of the adhoc compare running on this script, for use by its adhoc candidates
+	template <class TCompareStatus>
+	const AdhocScriptStatus<TCompareStatus>* GetAdhocIncumbent()
+	{
+		return compareHelper.template GetIncumbent<AdhocScriptStatus<TCompareStatus>>();
+	}
+
+	// Give up on the current script or adhoc candidate because it can't beat the incumbent.
+	// Returns false, so it can be returned from execution or an adhoc candidate. Recorded as aborted rather than failed.
+	bool Abort();
+
 	AdhocBaseScriptStatus ExecuteAdhoc(AdhocScript auto adhocScript);
 
 	template <class TAdhocCustomScriptStatus, AdhocCustomStatusScript<TAdhocCustomScriptStatus> F>
@@ -207,6 +255,12 @@ protected:
 	template <class TAdhocCustomScriptStatus, AdhocCustomStatusScript<TAdhocCustomScriptStatus> F>
 	AdhocScriptStatus<TAdhocCustomScriptStatus> ModifyAdhoc(F adhocScript);
 
+	// Run an adhoc script under its own budget, on top of the budgets of the scripts it runs in.
+	// Fails with budgetExceeded set once the budget is used up.
+	AdhocBaseScriptStatus ExecuteAdhoc(const ScriptBudget& budget, AdhocScript auto adhocScript);
+
+	AdhocBaseScriptStatus ModifyAdhoc(const ScriptBudget& budget, AdhocScript auto adhocScript);
+
 	AdhocBaseScriptStatus TestAdhoc(AdhocScript auto&& adhocScript);
 
 	template <class TAdhocCustomScriptStatus, AdhocCustomStatusScript<TAdhocCustomScriptStatus> F>
@@ -580,8 +634,252 @@ protected:
 			std::forward<F>(paramsGenerator), std::forward<G>(adhocScript), std::forward<H>(mutator), std::forward<I>(comparator), [](const AdhocScriptStatus<TCompareStatus>*) { return false; });
 	}
 
+	// Evaluate candidate diffs, advancing input prefixes shared between candidates only once.
+	// The terminator is checked in container order as candidates finish, so it can end the comparison early.
+	template <class TCompareStatus,
+		class TDiffContainer,
+		AdhocCompareScript<TCompareStatus, std::tuple<>> F,
+		AdhocScriptComparator<TCompareStatus> G,
+		AdhocScriptTerminator<TCompareStatus> H>
+		requires (std::derived_from<typename TDiffContainer::value_type, M64Base>)
+	AdhocScriptStatus<TCompareStatus> CompareDiffsAdhoc(const TDiffContainer& diffs, F&& evaluator, G&& comparator, H&& terminator)
+	{
+		return compareHelper.template CompareDiffsAdhoc<TCompareStatus>(
+			diffs, std::forward<F>(evaluator), std::forward<G>(comparator), std::forward<H>(terminator));
+	}
+
+	template <class TCompareStatus,
+		class TDiffContainer,
+		AdhocCompareScript<TCompareStatus, std::tuple<>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+		requires (std::derived_from<typename TDiffContainer::value_type, M64Base>)
+	AdhocScriptStatus<TCompareStatus> CompareDiffsAdhoc(const TDiffContainer& diffs, F&& evaluator, G&& comparator)
+	{
+		return compareHelper.template CompareDiffsAdhoc<TCompareStatus>(
+			diffs, std::forward<F>(evaluator), std::forward<G>(comparator), [](const AdhocScriptStatus<TCompareStatus>*) { return false; });
+	}
+
+	template <class TCompareStatus,
+		class TDiffContainer,
+		AdhocCompareScript<TCompareStatus, std::tuple<>> F,
+		AdhocScriptComparator<TCompareStatus> G,
+		AdhocScriptTerminator<TCompareStatus> H>
+		requires (std::derived_from<typename TDiffContainer::value_type, M64Base>)
+	AdhocScriptStatus<TCompareStatus> ModifyCompareDiffsAdhoc(const TDiffContainer& diffs, F&& evaluator, G&& comparator, H&& terminator)
+	{
+		return compareHelper.template ModifyCompareDiffsAdhoc<TCompareStatus>(
+			diffs, std::forward<F>(evaluator), std::forward<G>(comparator), std::forward<H>(terminator));
+	}
+
+	template <class TCompareStatus,
+		class TDiffContainer,
+		AdhocCompareScript<TCompareStatus, std::tuple<>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+		requires (std::derived_from<typename TDiffContainer::value_type, M64Base>)
+	AdhocScriptStatus<TCompareStatus> ModifyCompareDiffsAdhoc(const TDiffContainer& diffs, F&& evaluator, G&& comparator)
+	{
+		return compareHelper.template ModifyCompareDiffsAdhoc<TCompareStatus>(
+			diffs, std::forward<F>(evaluator), std::forward<G>(comparator), [](const AdhocScriptStatus<TCompareStatus>*) { return false; });
+	}
+
+	// Parallel versions of Compare and ModifyCompare that evaluate candidates on pooled resources, one worker per resource.
+	// Each worker replays this script's inputs up to the current frame first, so this pays off when candidates are expensive.
+	// The comparator and terminator run afterwards on this script in candidate order, so results match the serial versions
+	// as long as they only depend on the statuses. TStateTracker must match the state tracker of the top-level script.
+	// Throws if the top-level script started from an imported save, since its state can't be loaded into another resource.
+	template <derived_from_specialization_of<Script> TScript,
+		std::derived_from<Script<TResource>> TStateTracker = DefaultStateTracker<TResource>,
+		class TTupleContainer,
+		typename TTuple = typename TTupleContainer::value_type,
+		ScriptComparator<TScript> F,
+		ScriptTerminator<TScript> G>
+		requires (constructible_from_tuple<TScript, TTuple>)
+	ScriptStatus<TScript> ParallelCompare(ResourcePool<TResource>& resourcePool, const TTupleContainer& paramsList, F&& comparator, G&& terminator)
+	{
+		return compareHelper.template ParallelCompare<TScript, TStateTracker>(
+			resourcePool, paramsList, std::forward<F>(comparator), std::forward<G>(terminator));
+	}
+
+	template <derived_from_specialization_of<Script> TScript,
+		std::derived_from<Script<TResource>> TStateTracker = DefaultStateTracker<TResource>,
+		class TTupleContainer,
+		typename TTuple = typename TTupleContainer::value_type,
+		ScriptComparator<TScript> F>
+		requires (constructible_from_tuple<TScript, TTuple>)
+	ScriptStatus<TScript> ParallelCompare(ResourcePool<TResource>& resourcePool, const TTupleContainer& paramsList, F&& comparator)
+	{
+		return compareHelper.template ParallelCompare<TScript, TStateTracker>(
+			resourcePool, paramsList, std::forward<F>(comparator), [](const ScriptStatus<TScript>*) { return false; });
+	}
+
+	template <derived_from_specialization_of<Script> TScript,
+		typename TTuple,
+		std::derived_from<Script<TResource>> TStateTracker = DefaultStateTracker<TResource>,
+		ScriptParamsGenerator<TTuple> F,
+		ScriptComparator<TScript> G,
+		ScriptTerminator<TScript> H>
+		requires (constructible_from_tuple<TScript, TTuple>)
+	ScriptStatus<TScript> ParallelCompare(ResourcePool<TResource>& resourcePool, F&& paramsGenerator, G&& comparator, H&& terminator)
+	{
+		return compareHelper.template ParallelCompare<TScript, TStateTracker, TTuple>(
+			resourcePool, std::forward<F>(paramsGenerator), std::forward<G>(comparator), std::forward<H>(terminator));
+	}
+
+	template <derived_from_specialization_of<Script> TScript,
+		typename TTuple,
+		std::derived_from<Script<TResource>> TStateTracker = DefaultStateTracker<TResource>,
+		ScriptParamsGenerator<TTuple> F,
+		ScriptComparator<TScript> G>
+		requires (constructible_from_tuple<TScript, TTuple>)
+	ScriptStatus<TScript> ParallelCompare(ResourcePool<TResource>& resourcePool, F&& paramsGenerator, G&& comparator)
+	{
+		return compareHelper.template ParallelCompare<TScript, TStateTracker, TTuple>(
+			resourcePool, std::forward<F>(paramsGenerator), std::forward<G>(comparator), [](const ScriptStatus<TScript>*) { return false; });
+	}
+
+	template <derived_from_specialization_of<Script> TScript,
+		std::derived_from<Script<TResource>> TStateTracker = DefaultStateTracker<TResource>,
+		class TTupleContainer,
+		typename TTuple = typename TTupleContainer::value_type,
+		ScriptComparator<TScript> F,
+		ScriptTerminator<TScript> G>
+		requires (constructible_from_tuple<TScript, TTuple>)
+	ScriptStatus<TScript> ParallelModifyCompare(ResourcePool<TResource>& resourcePool, const TTupleContainer& paramsList, F&& comparator, G&& terminator)
+	{
+		return compareHelper.template ParallelModifyCompare<TScript, TStateTracker>(
+			resourcePool, paramsList, std::forward<F>(comparator), std::forward<G>(terminator));
+	}
+
+	template <derived_from_specialization_of<Script> TScript,
+		std::derived_from<Script<TResource>> TStateTracker = DefaultStateTracker<TResource>,
+		class TTupleContainer,
+		typename TTuple = typename TTupleContainer::value_type,
+		ScriptComparator<TScript> F>
+		requires (constructible_from_tuple<TScript, TTuple>)
+	ScriptStatus<TScript> ParallelModifyCompare(ResourcePool<TResource>& resourcePool, const TTupleContainer& paramsList, F&& comparator)
+	{
+		return compareHelper.template ParallelModifyCompare<TScript, TStateTracker>(
+			resourcePool, paramsList, std::forward<F>(comparator), [](const ScriptStatus<TScript>*) { return false; });
+	}
+
+	template <derived_from_specialization_of<Script> TScript,
+		typename TTuple,
+		std::derived_from<Script<TResource>> TStateTracker = DefaultStateTracker<TResource>,
+		ScriptParamsGenerator<TTuple> F,
+		ScriptComparator<TScript> G,
+		ScriptTerminator<TScript> H>
+		requires (constructible_from_tuple<TScript, TTuple>)
+	ScriptStatus<TScript> ParallelModifyCompare(ResourcePool<TResource>& resourcePool, F&& paramsGenerator, G&& comparator, H&& terminator)
+	{
+		return compareHelper.template ParallelModifyCompare<TScript, TStateTracker, TTuple>(
+			resourcePool, std::forward<F>(paramsGenerator), std::forward<G>(comparator), std::forward<H>(terminator));
+	}
+
+	template <derived_from_specialization_of<Script> TScript,
+		typename TTuple,
+		std::derived_from<Script<TResource>> TStateTracker = DefaultStateTracker<TResource>,
+		ScriptParamsGenerator<TTuple> F,
+		ScriptComparator<TScript> G>
+		requires (constructible_from_tuple<TScript, TTuple>)
+	ScriptStatus<TScript> ParallelModifyCompare(ResourcePool<TResource>& resourcePool, F&& paramsGenerator, G&& comparator)
+	{
+		return compareHelper.template ParallelModifyCompare<TScript, TStateTracker, TTuple>(
+			resourcePool, std::forward<F>(paramsGenerator), std::forward<G>(comparator), [](const ScriptStatus<TScript>*) { return false; });
+	}
+
+	template <derived_from_specialization_of<Script> TScript,
+		class TTupleContainer,
+		typename TTuple = typename TTupleContainer::value_type,
+		ScriptComparator<TScript> F>
+		requires (constructible_from_tuple<TScript, TTuple>)
+	std::vector<ScriptStatus<TScript>> CompareTopK(const TTupleContainer& paramsList, int64_t k, F&& comparator)
+	{
+		return compareHelper.template CompareTopK<TScript>(paramsList, k, std::forward<F>(comparator));
+	}
+
+	template <derived_from_specialization_of<Script> TScript,
+		typename TTuple,
+		ScriptParamsGenerator<TTuple> F,
+		ScriptComparator<TScript> G>
+		requires (constructible_from_tuple<TScript, TTuple>)
+	std::vector<ScriptStatus<TScript>> CompareTopK(F&& paramsGenerator, int64_t k, G&& comparator)
+	{
+		return compareHelper.template CompareTopK<TScript, TTuple>(std::forward<F>(paramsGenerator), k, std::forward<G>(comparator));
+	}
+
+	template <derived_from_specialization_of<Script> TScript,
+		class TTupleContainer,
+		typename TTuple = typename TTupleContainer::value_type,
+		ScriptComparator<TScript> F>
+		requires (constructible_from_tuple<TScript, TTuple>)
+	std::vector<ScriptStatus<TScript>> CompareBeam(const TTupleContainer& paramsList, int64_t k, int64_t nLevels, F&& comparator)
+	{
+		return compareHelper.template CompareBeam<TScript>(paramsList, k, nLevels, std::forward<F>(comparator));
+	}
+
+	template <derived_from_specialization_of<Script> TScript,
+		class TTupleContainer,
+		typename TTuple = typename TTupleContainer::value_type,
+		ScriptComparator<TScript> F>
+		requires (constructible_from_tuple<TScript, TTuple>)
+	std::vector<ScriptStatus<TScript>> ModifyCompareBeam(const TTupleContainer& paramsList, int64_t k, int64_t nLevels, F&& comparator)
+	{
+		return compareHelper.template ModifyCompareBeam<TScript>(paramsList, k, nLevels, std::forward<F>(comparator));
+	}
+
+	// One-dimensional searches over an integer parameter, e.g. an angle. The evaluator is called as evaluator(status, param),
+	// and each parameter is only simulated once per search. The substatus reports the best parameter and how many were simulated.
+	template <class TCompareStatus,
+		AdhocCompareScript<TCompareStatus, std::tuple<int64_t>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> GridSearchAdhoc(int64_t lo, int64_t hi, const std::vector<int64_t>& steps, F&& evaluator, G&& comparator)
+	{
+		return compareHelper.template GridSearchAdhoc<TCompareStatus>(lo, hi, steps, std::forward<F>(evaluator), std::forward<G>(comparator));
+	}
+
+	template <class TCompareStatus,
+		AdhocCompareScript<TCompareStatus, std::tuple<int64_t>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> ModifyGridSearchAdhoc(int64_t lo, int64_t hi, const std::vector<int64_t>& steps, F&& evaluator, G&& comparator)
+	{
+		return compareHelper.template ModifyGridSearchAdhoc<TCompareStatus>(lo, hi, steps, std::forward<F>(evaluator), std::forward<G>(comparator));
+	}
+
+	template <class TCompareStatus,
+		AdhocCompareScript<TCompareStatus, std::tuple<int64_t>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> GoldenSectionSearchAdhoc(int64_t lo, int64_t hi, int64_t step, F&& evaluator, G&& comparator)
+	{
+		return compareHelper.template GoldenSectionSearchAdhoc<TCompareStatus>(lo, hi, step, std::forward<F>(evaluator), std::forward<G>(comparator));
+	}
+
+	template <class TCompareStatus,
+		AdhocCompareScript<TCompareStatus, std::tuple<int64_t>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> ModifyGoldenSectionSearchAdhoc(int64_t lo, int64_t hi, int64_t step, F&& evaluator, G&& comparator)
+	{
+		return compareHelper.template ModifyGoldenSectionSearchAdhoc<TCompareStatus>(lo, hi, step, std::forward<F>(evaluator), std::forward<G>(comparator));
+	}
+
+	template <class TCompareStatus,
+		AdhocCompareScript<TCompareStatus, std::tuple<int64_t>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> BracketSearchAdhoc(int64_t start, int64_t step, int64_t lo, int64_t hi, F&& evaluator, G&& comparator)
+	{
+		return compareHelper.template BracketSearchAdhoc<TCompareStatus>(start, step, lo, hi, std::forward<F>(evaluator), std::forward<G>(comparator));
+	}
+
+	template <class TCompareStatus,
+		AdhocCompareScript<TCompareStatus, std::tuple<int64_t>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> ModifyBracketSearchAdhoc(int64_t start, int64_t step, int64_t lo, int64_t hi, F&& evaluator, G&& comparator)
+	{
+		return compareHelper.template ModifyBracketSearchAdhoc<TCompareStatus>(start, step, lo, hi, std::forward<F>(evaluator), std::forward<G>(comparator));
+	}
+
 	#pragma endregion
 
+	// Returns a copy, since the stored state can be evicted by the tracked state budget on any later frame advance
 	template <std::derived_from<Script<TResource>> TStateTracker>
 		requires std::constructible_from<TStateTracker>
 	typename TStateTracker::CustomScriptStatus GetTrackedState(int64_t frame)
@@ -621,9 +919,15 @@ protected:
 	M64Diff GetTotalDiff();
 	M64Diff GetBaseDiff();
 	void Apply(const M64Diff& m64Diff);
+	// Jump to the end of a diff whose resulting resource state is already known, e.g. from a cache, instead of replaying it.
+	// The state must be what applying the diff on top of the current inputs produces, otherwise the script desyncs.
+	template <class TState>
+	void ApplyWithState(const M64Diff& m64Diff, const TState& state);
 	void AdvanceFrameRead();
 	void AdvanceFrameWrite(Inputs inputs);
 	void OptionalSave();
+	void EnableCheckpointSchedule(int64_t saveMemBudget);
+	void DisableCheckpointSchedule();
 	void Save();
 	void Load(uint64_t frame);
 	void LongLoad(int64_t frame);
@@ -639,6 +943,9 @@ protected:
 	virtual bool execution() = 0;
 	virtual bool assertion() = 0;
 
+	// Limits on this script and everything it runs, e.g. set in the constructor. Unlimited by default.
+	ScriptBudget executionBudget = ScriptBudget();
+
 private:
 	friend class ScriptFriend<TResource>;
 	friend class SaveMetadata<TResource>;
@@ -648,17 +955,23 @@ private:
 	int64_t _adhocLevel = 0;
 	int32_t _initialFrame = 0;
 	std::unordered_map<int64_t, BaseScriptStatus> BaseStatus;
-	std::unordered_map<int64_t, std::map<int64_t, SlotHandle<TResource>>> saveBank;// contains handles to savestates
-	std::unordered_map<int64_t, std::map<int64_t, uint64_t>> frameCounter;// tracks opportunity cost of having to frame advance from an earlier save
-	std::unordered_map<int64_t, std::map<int64_t, SaveMetadata<TResource>>> saveCache;// stores metadata of ancestor saves to save recursion time
-	std::unordered_map<int64_t, std::map<int64_t, InputsMetadata<TResource>>> inputsCache;// caches ancestor inputs to save recursion time
+	std::unordered_map<int64_t, FrameCache<SlotHandle<TResource>>> saveBank;// contains handles to savestates
+	std::unordered_map<int64_t, FrameCache<uint64_t>> frameCounter;// tracks opportunity cost of having to frame advance from an earlier save
+	std::unordered_map<int64_t, FrameCache<SaveMetadata<TResource>>> saveCache;// stores metadata of ancestor saves to save recursion time
+	std::unordered_map<int64_t, FrameCache<InputsMetadata<TResource>>> inputsCache;// caches ancestor inputs to save recursion time
+	std::unordered_map<int64_t, std::vector<uint64_t>> inputsHashes;// hashes of all inputs prior to each frame, for the checkpoint cache
 	std::unordered_map<int64_t, std::set<int64_t>> loadTracker;// track past loads to know whether a cached save is optimal
 	Script* _parentScript;
 	Script* _rootScript;
 	bool isStateTracker = false;
+	bool _tracksStates = false;// only meaningful on the root script. False if the state tracker is DefaultStateTracker.
+	int64_t _checkpointMemBudget = 0;// if nonzero, saves made while replaying also follow a binomial checkpoint schedule
+	std::map<int64_t, std::pair<SaveMetadata<TResource>, int64_t>> scheduledCheckpoints;// saves the checkpoint schedule created, with their slot ids
 	ScriptCompareHelper<TResource> compareHelper = ScriptCompareHelper<TResource>(this);
+	ScriptBudgetScope* _budgetScope = nullptr;// innermost budget this script is running under, if any
 
 	bool Run();
+	bool RunBase();
 
 	void Initialize(Script<TResource>* parentScript);
 	SaveMetadata<TResource> GetLatestSave(int64_t frame);
@@ -667,16 +980,24 @@ private:
 	InputsMetadata<TResource> GetInputsMetadataAndCache(int64_t frame);
 	void DeleteSave(int64_t frame, int64_t adhocLevel);
 	void SetInputs(Inputs inputs);
-	void Revert(uint64_t frame, const M64Diff& m64, std::map<int64_t, SlotHandle<TResource>>& childSaveBank, Script<TResource>* childScript);
+	void Revert(uint64_t frame, const M64Diff& m64, FrameCache<SlotHandle<TResource>>& childSaveBank, Script<TResource>* childScript);
 	void AdvanceFrameRead(uint64_t& counter);
+	void AdvanceFrameReadBase();
+	void ChargeBudget(uint64_t nFrameAdvances, uint64_t nLoads);
 	uint64_t GetFrameCounter(InputsMetadata<TResource> cachedInputs);
 	uint64_t IncrementFrameCounter(InputsMetadata<TResource> cachedInputs);
-	void ApplyChildDiff(const BaseScriptStatus& status, std::map<int64_t, SlotHandle<TResource>>& childSaveBank, int64_t initialFrame, Script<TResource>* childScript);
+	void ApplyChildDiff(const BaseScriptStatus& status, FrameCache<SlotHandle<TResource>>& childSaveBank, int64_t initialFrame, Script<TResource>* childScript);
+	void InvalidateCaches(int64_t frame);
+	const std::vector<uint64_t>& GetInputsHashes(int64_t frame);
+	void UpdateTrackedState(int64_t frame);
 	SaveMetadata<TResource> Save(int64_t adhocLevel);
 	void LoadBase(uint64_t frame, bool desync);
+	std::vector<int64_t> GetScheduledCheckpointFrames(int64_t startFrame, int64_t endFrame);
+	SaveMetadata<TResource> SaveScheduledCheckpoint(const InputsMetadata<TResource>& inputsMetadata);
 
+	// The call site defaults to the type of the adhoc lambda, which is unique to where it is written
 	template <typename F>
-	BaseScriptStatus ExecuteAdhocBase(F adhocScript);
+	BaseScriptStatus ExecuteAdhocBase(F adhocScript, const std::type_info& callSite = typeid(F));
 
 	template <derived_from_specialization_of<Script> TStateTracker>
 	ScriptStatus<TStateTracker> ExecuteStateTracker(int64_t frame, std::shared_ptr<StateTrackerFactoryBase<TStateTracker>> stateTrackerFactory)
@@ -685,6 +1006,7 @@ private:
 
 		TStateTracker script = stateTrackerFactory->Generate();
 		script.Initialize(this);
+		script._budgetScope = nullptr; // State tracking is bookkeeping, not work done by the script
 
 		uint64_t loadStateTimeStart = resource->GetTotalLoadStateTime();
 		uint64_t saveStateTimeStart = resource->GetTotalSaveStateTime();
@@ -716,7 +1038,7 @@ private:
 	}
 
 	// Needed for state tracking. These do nothing, but TopLevelScript overrides them. Can't access explicitly because of lack of template information.
-	virtual void TrackState(Script<TResource>* currentScript, const InputsMetadata<TResource>& inputsMetadata) { return; }
+	virtual void TrackState(Script<TResource>* currentScript, int64_t frame) { return; }
 	virtual bool TrackedStateExistsInternal(Script<TResource>* currentScript, const InputsMetadata<TResource>& inputsMetadata) { return false; }
 	virtual void PushTrackedStatesContainer(Script<TResource>* currentScript, int adhocLevel) { return; }
 	virtual void PopTrackedStatesContainer(Script<TResource>* currentScript, int adhocLevel) { return; }
@@ -767,14 +1089,14 @@ public:
 		return script->BaseStatus;
 	}
 
-	static std::unordered_map<int64_t, std::map<int64_t, InputsMetadata<TResource>>>& GetInputsCache(Script<TResource>* script)
+	static std::unordered_map<int64_t, FrameCache<InputsMetadata<TResource>>>& GetInputsCache(Script<TResource>* script)
 	{
 		return script->inputsCache;
 	}
 
 	static void DisposeSlotHandles(Script<TResource>* script)
 	{
-		script->saveBank[0].erase(script->saveBank[0].begin(), script->saveBank[0].end());
+		script->saveBank[0].Clear();
 	}
 
 	static void Initialize(Script<TResource>* script, Script<TResource>* parentScript)
@@ -797,6 +1119,36 @@ public:
 		return script->isStateTracker;
 	}
 
+	static void SetTracksStates(Script<TResource>* script, bool tracksStates)
+	{
+		script->_tracksStates = tracksStates;
+	}
+
+	static void SetIsStateTracker(Script<TResource>* script, bool isStateTracker)
+	{
+		script->isStateTracker = isStateTracker;
+	}
+
+	static void SetBudgetScope(Script<TResource>* script, ScriptBudgetScope* budgetScope)
+	{
+		script->_budgetScope = budgetScope;
+	}
+
+	static bool Validate(Script<TResource>* script)
+	{
+		return script->validation();
+	}
+
+	static bool Assert(Script<TResource>* script)
+	{
+		return script->assertion();
+	}
+
+	static InputsMetadata<TResource> GetInputsMetadataAndCache(Script<TResource>* script, int64_t frame)
+	{
+		return script->GetInputsMetadataAndCache(frame);
+	}
+
 	template <derived_from_specialization_of<Script> TStateTracker>
 	static ScriptStatus<TStateTracker> ExecuteStateTracker(
 		int64_t frame, Script<TResource>* script, std::shared_ptr<StateTrackerFactoryBase<TStateTracker>> stateTrackerFactory)
@@ -846,9 +1198,18 @@ public:
 	template <derived_from_specialization_of<TopLevelScript> TTopLevelScript, typename... TStateTrackerParams, typename... Ts>
 		requires(std::constructible_from<TTopLevelScript, Ts...> && std::constructible_from<TStateTracker, TStateTrackerParams...>)
 	static ScriptStatus<TTopLevelScript> MainImport(M64& m64, std::shared_ptr<std::tuple<TStateTrackerParams...>> stateTrackerParams, TResource* resource, Ts&&... params)
+	{
+		return MainImportShared<TTopLevelScript>(m64,
+			std::make_shared<StateTrackerFactory<TStateTracker, TStateTrackerParams...>>(stateTrackerParams), resource, std::forward<Ts>(params)...);
+	}
+
+	// Same as MainImport, but shares an existing state tracker factory, e.g. with the script that started a parallel compare
+	template <derived_from_specialization_of<TopLevelScript> TTopLevelScript, typename... Ts>
+		requires(std::constructible_from<TTopLevelScript, Ts...>)
+	static ScriptStatus<TTopLevelScript> MainImportShared(M64& m64, std::shared_ptr<StateTrackerFactoryBase<TStateTracker>> stateTrackerFactory, TResource* resource, Ts&&... params)
 	{
 		TTopLevelScript script = TTopLevelScript(std::forward<Ts>(params)...);
-		script.stateTrackerFactory = std::make_shared<StateTrackerFactory<TStateTracker, TStateTrackerParams...>>(stateTrackerParams);
+		script.stateTrackerFactory = stateTrackerFactory;
 
 		// Initialize start save if resource is new. If not, load start save to reset resource.
 		if (resource->initialFrame == -1)
@@ -925,21 +1286,34 @@ public:
 protected:
 	M64* _m64 = nullptr;
 
+	// Set by derived scripts to bound the memory used by tracked states. Unlimited by default.
+	// With a budget, states outside the most recent frames are evicted as new frames are tracked, and recomputed when next requested.
+	TrackedStateBudget trackedStateBudget;
+
 private:
 	friend class Script<TResource>;
 	friend class TopLevelScript<TResource, TStateTracker>;
+	friend class ScriptCompareHelper<TResource>;
 
 	// Data: trackedStates[script][adhocLevel][frame] = state;
 	std::shared_ptr<StateTrackerFactoryBase<TStateTracker>> stateTrackerFactory = nullptr;
-	std::unordered_map<Script<TResource>*, std::unordered_map<int64_t, std::map<int64_t, typename TStateTracker::CustomScriptStatus>>> trackedStates;
+	std::unordered_map<Script<TResource>*, std::unordered_map<int64_t, TrackedStateBuffer<typename TStateTracker::CustomScriptStatus>>> trackedStates;
+	uint64_t trackedStateMemory = 0;
+	uint64_t peakTrackedStateMemory = 0;
+	uint64_t trackedStateEvictionThreshold = 0;
+	uint64_t nEvictedTrackedStates = 0;
 
-	void TrackState(Script<TResource>* currentScript, const InputsMetadata<TResource>& inputsMetadata) override;
+	void TrackState(Script<TResource>* currentScript, int64_t frame) override;
 	bool TrackedStateExistsInternal(Script<TResource>* currentScript, const InputsMetadata<TResource>& inputsMetadata) override;
 	void PushTrackedStatesContainer(Script<TResource>* currentScript, int adhocLevel) override;
 	void PopTrackedStatesContainer(Script<TResource>* currentScript, int adhocLevel) override;
 	void MoveSyncedTrackedStates(Script<TResource>* sourceScript, int sourceAdhocLevel, Script<TResource>* destScript, int destAdhocLevel) override;
 	void EraseTrackedStates(Script<TResource>* currentScript, int adhocLevel, int64_t firstFrame) override;
-	typename TStateTracker::CustomScriptStatus GetTrackedStateInternal(Script<TResource>* currentScript, const InputsMetadata<TResource>& inputsMetadata);
+	const typename TStateTracker::CustomScriptStatus& GetTrackedStateInternal(Script<TResource>* currentScript, const InputsMetadata<TResource>& inputsMetadata);
+	bool StreamTrackedState(Script<TResource>* currentScript, const InputsMetadata<TResource>& inputsMetadata);
+	const typename TStateTracker::CustomScriptStatus& SetTrackedState(const InputsMetadata<TResource>& inputsMetadata, typename TStateTracker::CustomScriptStatus&& state);
+	void RecordTrackedStateMemory(uint64_t previousMemoryUsage, uint64_t memoryUsage);
+	void EnforceTrackedStateBudget();
 
 	InputsMetadata<TResource> GetInputsMetadata(int64_t frame) override;
 
@@ -948,9 +1322,10 @@ private:
 	{
 		script._m64 = &m64;
 		script.resource = resource;
+		ScriptFriend<TResource>::SetTracksStates(&script, !std::is_same<TStateTracker, DefaultStateTracker<TResource>>::value);
 		ScriptFriend<TResource>::Initialize(&script, nullptr);
 
-		script.TrackState(&script, script.GetInputsMetadata(ScriptFriend<TResource>::GetCurrentFrame(&script)));
+		script.TrackState(&script, ScriptFriend<TResource>::GetCurrentFrame(&script));
 
 		uint64_t loadStateTimeStart = resource->GetTotalLoadStateTime();
 		uint64_t saveStateTimeStart = resource->GetTotalSaveStateTime();
@@ -965,6 +1340,9 @@ private:
 		baseStatus.saveDuration = resource->GetTotalSaveStateTime() - saveStateTimeStart;
 		baseStatus.advanceFrameDuration = resource->GetTotalFrameAdvanceTime() - advanceFrameTimeStart;
 		baseStatus.totalDuration = finish - start;
+		baseStatus.trackedStateMemory = script.trackedStateMemory;
+		baseStatus.peakTrackedStateMemory = script.peakTrackedStateMemory;
+		baseStatus.nEvictedTrackedStates = script.nEvictedTrackedStates;
 
 		//Dispose of slot handles before resource goes out of scope because they trigger destructor events in the resource.
 		ScriptFriend<TResource>::DisposeSlotHandles(&script);
@@ -973,6 +1351,45 @@ private:
 	}
 };
 
+/// <summary>
+/// Brings a pooled resource to the state of the script that started a parallel compare by replaying its inputs,
+/// then runs candidates pulled from a shared counter until none are left.
+/// Statuses are stored by candidate index, so results don't depend on which worker ran which candidate.
+/// </summary>
+template <derived_from_specialization_of<Resource> TResource, class TStateTracker, class TScript, class TTuple>
+class ParallelCompareWorker : public TopLevelScript<TResource, TStateTracker>
+{
+public:
+	ParallelCompareWorker(int64_t baseFrame, const std::vector<TTuple>& paramsList,
+		std::vector<ScriptStatus<TScript>>& statuses, std::atomic<int64_t>& nextCandidate)
+		: _baseFrame(baseFrame), _paramsList(paramsList), _statuses(statuses), _nextCandidate(nextCandidate) {}
+
+	bool validation() { return true; }
+
+	bool execution()
+	{
+		this->LongLoad(_baseFrame);
+
+		for (int64_t candidate = _nextCandidate++; candidate < static_cast<int64_t>(_paramsList.size()); candidate = _nextCandidate++)
+		{
+			TTuple params = _paramsList[candidate];
+			_statuses[candidate] = std::apply(
+				[&]<typename... Ts>(Ts&&... p) -> ScriptStatus<TScript> { return this->template Execute<TScript>(std::forward<Ts>(p)...); },
+				params);
+		}
+
+		return true;
+	}
+
+	bool assertion() { return true; }
+
+private:
+	int64_t _baseFrame;
+	const std::vector<TTuple>& _paramsList;
+	std::vector<ScriptStatus<TScript>>& _statuses;
+	std::atomic<int64_t>& _nextCandidate;
+};
+
 class DefaultState {};
 
 class DefaultResourceConfig {};
@@ -3,7 +3,9 @@
 #error "Script.t.hpp should only be included by Script.hpp"
 #else
 
+#include <algorithm>
 #include <chrono>
+#include <exception>
 
 template <derived_from_specialization_of<Resource> TResource>
 SlotHandle<TResource>::~SlotHandle()
@@ -38,6 +40,7 @@ void Script<TResource>::Initialize(Script<TResource>* parentScript)
 	{
 		resource = _parentScript->resource;
 		_rootScript = _parentScript->_rootScript;
+		_budgetScope = _parentScript->_budgetScope;
 	}
 	else
 		_rootScript = this;
@@ -50,10 +53,29 @@ void Script<TResource>::Initialize(Script<TResource>* parentScript)
 
 template <derived_from_specialization_of<Resource> TResource>
 bool Script<TResource>::Run()
+{
+	// Budgets are enforced by the adhoc scripts in RunBase, so nothing is thrown past this point
+	ScriptBudgetScope* parentBudgetScope = _budgetScope;
+	std::optional<ScriptBudgetScope> budgetScope;
+	if (!executionBudget.IsUnlimited())
+		_budgetScope = &budgetScope.emplace(executionBudget, parentBudgetScope);
+
+	BaseScriptStatus& baseStatus = BaseStatus[_adhocLevel];
+	ScriptProfiler::Scope profilerScope = ScriptProfiler::Scope(typeid(*this), false, baseStatus.nFrameAdvances, baseStatus.nSaves, baseStatus.nLoads);
+	bool result = RunBase();
+	_budgetScope = parentBudgetScope;
+
+	return result;
+}
+
+template <derived_from_specialization_of<Resource> TResource>
+bool Script<TResource>::RunBase()
 {
 	// Validate
 	auto start = get_time();
-	BaseStatus[_adhocLevel].validated = ExecuteAdhoc([&] { return validation(); }).executed;
+	auto validationStatus = ExecuteAdhoc([&] { return validation(); });
+	BaseStatus[_adhocLevel].validated = validationStatus.executed;
+	BaseStatus[_adhocLevel].budgetExceeded = validationStatus.budgetExceeded;
 	auto finish = get_time();
 
 	BaseStatus[_adhocLevel].validationDuration = finish - start;
@@ -63,7 +85,10 @@ bool Script<TResource>::Run()
 
 	// Execute
 	start = get_time();
-	BaseStatus[_adhocLevel].executed = ModifyAdhoc([&] { return execution(); }).executed;
+	auto executionStatus = ModifyAdhoc([&] { return execution(); });
+	BaseStatus[_adhocLevel].executed = executionStatus.executed;
+	BaseStatus[_adhocLevel].aborted = executionStatus.aborted;
+	BaseStatus[_adhocLevel].budgetExceeded = executionStatus.budgetExceeded;
 	finish = get_time();
 
 	BaseStatus[_adhocLevel].executionDuration = finish - start;
@@ -73,7 +98,9 @@ bool Script<TResource>::Run()
 
 	// Assert
 	start = get_time();
-	BaseStatus[_adhocLevel].asserted = ExecuteAdhoc([&] { return assertion(); }).executed;
+	auto assertionStatus = ExecuteAdhoc([&] { return assertion(); });
+	BaseStatus[_adhocLevel].asserted = assertionStatus.executed;
+	BaseStatus[_adhocLevel].budgetExceeded = assertionStatus.budgetExceeded;
 	finish = get_time();
 
 	BaseStatus[_adhocLevel].assertionDuration = finish - start;
@@ -81,6 +108,22 @@ bool Script<TResource>::Run()
 	return BaseStatus[_adhocLevel].asserted;
 }
 
+template <derived_from_specialization_of<Resource> TResource>
+bool Script<TResource>::Abort()
+{
+	BaseStatus[_adhocLevel].aborted = true;
+	BaseStatus[_adhocLevel].nAborts++;
+	return false;
+}
+
+// Throws ScriptBudgetExceeded if this script or anything enclosing it is over budget
+template <derived_from_specialization_of<Resource> TResource>
+void Script<TResource>::ChargeBudget(uint64_t nFrameAdvances, uint64_t nLoads)
+{
+	if (_budgetScope && !isStateTracker)
+		_budgetScope->Charge(nFrameAdvances, nLoads);
+}
+
 template <derived_from_specialization_of<Resource> TResource>
 void Script<TResource>::CopyVec3f(Vec3f dest, Vec3f source)
 {
@@ -97,13 +140,20 @@ uint64_t Script<TResource>::GetCurrentFrame()
 
 template <derived_from_specialization_of<Resource> TResource>
 void Script<TResource>::AdvanceFrameRead()
+{
+	AdvanceFrameReadBase();
+	ChargeBudget(1, 0);
+}
+
+template <derived_from_specialization_of<Resource> TResource>
+void Script<TResource>::AdvanceFrameReadBase()
 {
 	int64_t currentFrame = GetCurrentFrame();
 	SetInputs(GetInputs(currentFrame++));
 	resource->FrameAdvance();
 	BaseStatus[_adhocLevel].nFrameAdvances++;
 
-	_rootScript->TrackState(this, GetInputsMetadataAndCache(currentFrame));
+	UpdateTrackedState(currentFrame);
 }
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -113,12 +163,8 @@ void Script<TResource>::AdvanceFrameWrite(Inputs inputs)
 	uint64_t currentFrame = GetCurrentFrame();
 	BaseStatus[_adhocLevel].m64Diff.frames[currentFrame] = inputs;
 
-	// Erase all saves, cached saves and inputs, tracked loads and frame counters after this point, as well as the cached input on this frame
-	inputsCache[_adhocLevel].erase(inputsCache[_adhocLevel].lower_bound(currentFrame), inputsCache[_adhocLevel].end());
-	frameCounter[_adhocLevel].erase(frameCounter[_adhocLevel].upper_bound(currentFrame), frameCounter[_adhocLevel].end());
-	saveBank[_adhocLevel].erase(saveBank[_adhocLevel].upper_bound(currentFrame), saveBank[_adhocLevel].end());
-	saveCache[_adhocLevel].erase(saveCache[_adhocLevel].upper_bound(currentFrame), saveCache[_adhocLevel].end());
-	_rootScript->EraseTrackedStates(this, _adhocLevel, currentFrame);
+	// Invalidate all saves, cached saves and inputs, tracked states and frame counters after this point, as well as the cached input on this frame
+	InvalidateCaches(currentFrame);
 
 	// Set inputs and advance frame
 	SetInputs(inputs);
@@ -126,7 +172,9 @@ void Script<TResource>::AdvanceFrameWrite(Inputs inputs)
 	BaseStatus[_adhocLevel].nFrameAdvances++;
 
 	currentFrame++;
-	_rootScript->TrackState(this, GetInputsMetadataAndCache(currentFrame));
+	UpdateTrackedState(currentFrame);
+
+	ChargeBudget(1, 0);
 }
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -139,14 +187,11 @@ void Script<TResource>::Apply(const M64Diff& m64Diff)
 	uint64_t lastFrame = m64Diff.frames.rbegin()->first;
 
 	Load(firstFrame);
+	uint64_t nFrameAdvancesStart = BaseStatus[_adhocLevel].nFrameAdvances;
 
-	// Erase all saves, cached saves, and frame counters after this point
+	// Invalidate all saves, cached saves, and frame counters after this point
 	uint64_t currentFrame = GetCurrentFrame();
-	inputsCache[_adhocLevel].erase(inputsCache[_adhocLevel].lower_bound(currentFrame), inputsCache[_adhocLevel].end());
-	frameCounter[_adhocLevel].erase(frameCounter[_adhocLevel].upper_bound(currentFrame), frameCounter[_adhocLevel].end());
-	saveBank[_adhocLevel].erase(saveBank[_adhocLevel].upper_bound(currentFrame), saveBank[_adhocLevel].end());
-	saveCache[_adhocLevel].erase(saveCache[_adhocLevel].upper_bound(currentFrame), saveCache[_adhocLevel].end());
-	_rootScript->EraseTrackedStates(this, _adhocLevel, currentFrame);
+	InvalidateCaches(currentFrame);
 
 	while (currentFrame <= lastFrame)
 	{
@@ -163,12 +208,33 @@ void Script<TResource>::Apply(const M64Diff& m64Diff)
 		BaseStatus[_adhocLevel].nFrameAdvances++;
 
 		currentFrame++;
-		_rootScript->TrackState(this, GetInputsMetadataAndCache(currentFrame));
+		UpdateTrackedState(currentFrame);
 	}
+
+	ChargeBudget(BaseStatus[_adhocLevel].nFrameAdvances - nFrameAdvancesStart, 0);
+}
+
+template <derived_from_specialization_of<Resource> TResource>
+template <class TState>
+void Script<TResource>::ApplyWithState(const M64Diff& m64Diff, const TState& state)
+{
+	if (m64Diff.frames.empty())
+		return;
+
+	// Saves, cached inputs and tracked states after the first frame of the diff no longer apply
+	InvalidateCaches(m64Diff.frames.begin()->first);
+	for (const auto& [frame, inputs] : m64Diff.frames)
+		BaseStatus[_adhocLevel].m64Diff.frames[frame] = inputs;
+
+	resource->LoadState(state);
+	BaseStatus[_adhocLevel].nLoads++;
+	UpdateTrackedState(GetCurrentFrame());
+
+	ChargeBudget(0, 1);
 }
 
 template <derived_from_specialization_of<Resource> TResource>
-void Script<TResource>::ApplyChildDiff(const BaseScriptStatus& status, std::map<int64_t, SlotHandle<TResource>>& childSaveBank, int64_t initialFrame, Script<TResource>* childScript)
+void Script<TResource>::ApplyChildDiff(const BaseScriptStatus& status, FrameCache<SlotHandle<TResource>>& childSaveBank, int64_t initialFrame, Script<TResource>* childScript)
 {
 	//Revert if script was unsuccessful
 	if (!status.asserted)
@@ -184,12 +250,8 @@ void Script<TResource>::ApplyChildDiff(const BaseScriptStatus& status, std::map<
 		firstFrame = status.m64Diff.frames.begin()->first;
 		lastFrame = status.m64Diff.frames.rbegin()->first;
 
-		// Erase all saves, cached saves, and frame counters after this point
-		inputsCache[_adhocLevel].erase(inputsCache[_adhocLevel].lower_bound(firstFrame), inputsCache[_adhocLevel].end());
-		frameCounter[_adhocLevel].erase(frameCounter[_adhocLevel].upper_bound(firstFrame), frameCounter[_adhocLevel].end());
-		saveBank[_adhocLevel].erase(saveBank[_adhocLevel].upper_bound(firstFrame), saveBank[_adhocLevel].end());
-		saveCache[_adhocLevel].erase(saveCache[_adhocLevel].upper_bound(firstFrame), saveCache[_adhocLevel].end());
-		_rootScript->EraseTrackedStates(this, _adhocLevel, firstFrame);
+		// Invalidate all saves, cached saves, and frame counters after this point
+		InvalidateCaches(firstFrame);
 
 		//Apply diff. State is already synced from child script, so no need to update it
 		for (uint64_t frame = firstFrame; frame <= lastFrame; frame++)
@@ -201,17 +263,61 @@ void Script<TResource>::ApplyChildDiff(const BaseScriptStatus& status, std::map<
 
 	//Move child saves to parent because they are still synced
 	//If child is ad-hoc script, pop the save bank
-	std::move(childSaveBank.begin(), childSaveBank.end(), std::insert_iterator(saveBank[_adhocLevel], saveBank[_adhocLevel].end()));
+	childSaveBank.MoveInto(saveBank[_adhocLevel], INT64_MAX);
 	if (saveBank.contains(_adhocLevel + 1))
 		saveBank.erase(_adhocLevel + 1);
 
 	int childAdhocLevel = this == childScript ? _adhocLevel + 1 : 0; // Ad-hoc script vs. regular script
 	_rootScript->MoveSyncedTrackedStates(childScript, childAdhocLevel, this, _adhocLevel);
 
+	// Not charged against the budget, as the child already did this work
 	if (!status.m64Diff.frames.empty())
-		Load(lastFrame + 1); //Forward state to end of diff
+		LoadBase(lastFrame + 1, false); //Forward state to end of diff
 	else
-		Load(initialFrame);
+		LoadBase(initialFrame, false);
+}
+
+// Entries are only marked stale here, so writing frame after frame costs O(1) per write. They are reclaimed in bulk later.
+template <derived_from_specialization_of<Resource> TResource>
+void Script<TResource>::InvalidateCaches(int64_t frame)
+{
+	inputsCache[_adhocLevel].Invalidate(frame);
+	frameCounter[_adhocLevel].Invalidate(frame + 1);
+	saveBank[_adhocLevel].Invalidate(frame + 1);
+	saveCache[_adhocLevel].Invalidate(frame + 1);
+	if (_rootScript->_tracksStates)
+		_rootScript->EraseTrackedStates(this, _adhocLevel, frame);
+
+	auto hashes = inputsHashes.find(_adhocLevel);
+	if (hashes != inputsHashes.end() && static_cast<int64_t>(hashes->second.size()) > frame + 1)
+		hashes->second.resize(frame + 1);
+}
+
+// Hashes of all inputs prior to each frame up to and including frame. Extends the hashes kept from earlier calls.
+template <derived_from_specialization_of<Resource> TResource>
+const std::vector<uint64_t>& Script<TResource>::GetInputsHashes(int64_t frame)
+{
+	std::vector<uint64_t>& hashes = inputsHashes[_adhocLevel];
+	if (hashes.empty())
+		hashes.push_back(HashBytes(nullptr, 0));
+
+	for (int64_t inputsFrame = hashes.size() - 1; inputsFrame < frame; inputsFrame++)
+	{
+		Inputs inputs = GetInputsMetadata(inputsFrame).inputs;
+		uint64_t hash = HashBytes(&inputs.buttons, sizeof(inputs.buttons), hashes.back());
+		hash = HashBytes(&inputs.stick_x, sizeof(inputs.stick_x), hash);
+		hashes.push_back(HashBytes(&inputs.stick_y, sizeof(inputs.stick_y), hash));
+	}
+
+	return hashes;
+}
+
+// Only computes inputs metadata if a state tracker is installed, so frame advances cost nothing extra otherwise
+template <derived_from_specialization_of<Resource> TResource>
+void Script<TResource>::UpdateTrackedState(int64_t frame)
+{
+	if (_rootScript->_tracksStates)
+		_rootScript->TrackState(this, frame);
 }
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -289,9 +395,10 @@ InputsMetadata<TResource> Script<TResource>::GetInputsMetadata(int64_t frame)
 			}
 		}
 
-		if (inputsCache[adhocLevel].contains(frame))
+		InputsMetadata<TResource>* cachedMetadata = inputsCache[adhocLevel].Find(frame);
+		if (cachedMetadata)
 		{
-			InputsMetadata<TResource> metadata = inputsCache[adhocLevel][frame];
+			InputsMetadata<TResource> metadata = *cachedMetadata;
 			if (stateOwnerAdhocLevel != -1)
 			{
 				metadata.stateOwner = this;
@@ -360,9 +467,10 @@ InputsMetadata<TResource> TopLevelScript<TResource, TStateTracker>::GetInputsMet
 			}
 		}
 
-		if (ScriptFriend<TResource>::GetInputsCache(this)[adhocLevel].contains(frame))
+		InputsMetadata<TResource>* cachedMetadata = ScriptFriend<TResource>::GetInputsCache(this)[adhocLevel].Find(frame);
+		if (cachedMetadata)
 		{
-			InputsMetadata<TResource> metadata = ScriptFriend<TResource>::GetInputsCache(this)[adhocLevel][frame];
+			InputsMetadata<TResource> metadata = *cachedMetadata;
 			if (stateOwnerAdhocLevel != -1)
 				metadata.stateOwnerAdhocLevel = stateOwnerAdhocLevel;
 
@@ -401,18 +509,12 @@ InputsMetadata<TResource> Script<TResource>::GetInputsMetadataAndCache(int64_t f
 template <derived_from_specialization_of<Resource> TResource>
 uint64_t Script<TResource>::GetFrameCounter(InputsMetadata<TResource> cachedInputs)
 {
-	if (!cachedInputs.stateOwner->frameCounter[cachedInputs.stateOwnerAdhocLevel].contains(cachedInputs.frame))
-		cachedInputs.stateOwner->frameCounter[cachedInputs.stateOwnerAdhocLevel][cachedInputs.frame] = 0;
-
 	return cachedInputs.stateOwner->frameCounter[cachedInputs.stateOwnerAdhocLevel][cachedInputs.frame];
 }
 
 template <derived_from_specialization_of<Resource> TResource>
 uint64_t Script<TResource>::IncrementFrameCounter(InputsMetadata<TResource> cachedInputs)
 {
-	if (!cachedInputs.stateOwner->frameCounter[cachedInputs.stateOwnerAdhocLevel].contains(cachedInputs.frame))
-		cachedInputs.stateOwner->frameCounter[cachedInputs.stateOwnerAdhocLevel][cachedInputs.frame] = 0;
-
 	//Return value BEFORE incrementing
 	return cachedInputs.stateOwner->frameCounter[cachedInputs.stateOwnerAdhocLevel][cachedInputs.frame]++;
 }
@@ -431,20 +533,18 @@ SaveMetadata<TResource> Script<TResource>::GetLatestSave(int64_t frame)
 		while (true)
 		{
 			//Get most recent save in script
-			auto save = saveBank[adhocLevel].empty() || earlyFrame < saveBank[adhocLevel].begin()->first
-				? saveBank[adhocLevel].end()
-				: std::prev(saveBank[adhocLevel].upper_bound(earlyFrame));
+			int64_t saveFrame = saveBank[adhocLevel].GetLatestFrame(earlyFrame);
 
 			//Verify save exists and select the more recent save
-			if (save != saveBank[adhocLevel].end())
+			if (saveFrame != -1)
 			{
-				if (!save->second.isValid())
+				if (!saveBank[adhocLevel].Find(saveFrame)->isValid())
 				{
-					saveBank[adhocLevel].erase(save->first);
+					saveBank[adhocLevel].Erase(saveFrame);
 					continue;
 				}
-				else if (save->first >= bestSave.frame)
-					bestSave = SaveMetadata<TResource>(this, save->first, adhocLevel);
+				else if (saveFrame >= bestSave.frame)
+					bestSave = SaveMetadata<TResource>(this, saveFrame, adhocLevel);
 			}
 
 			break;
@@ -453,28 +553,26 @@ SaveMetadata<TResource> Script<TResource>::GetLatestSave(int64_t frame)
 		//Check for cached save
 		while (true)
 		{
-			auto cachedSave = saveCache[adhocLevel].empty() || earlyFrame < saveCache[adhocLevel].begin()->first
-				? saveCache[adhocLevel].end()
-				: std::prev(saveCache[adhocLevel].upper_bound(earlyFrame));
-
-			if (cachedSave != saveCache[adhocLevel].end())
+			int64_t cachedSaveFrame = saveCache[adhocLevel].GetLatestFrame(earlyFrame);
+			if (cachedSaveFrame != -1)
 			{
 				//This is the purpose of caching saves: end recursion when a cached save is found. Boosts performance.
-				if (cachedSave->second.IsValid())
+				SaveMetadata<TResource> cachedSave = *saveCache[adhocLevel].Find(cachedSaveFrame);
+				if (cachedSave.IsValid())
 				{
-					if (cachedSave->first >= bestSave.frame)
+					if (cachedSaveFrame >= bestSave.frame)
 					{
 						//However, if there was a load between the target frame and the cached save, it may not be optimal and we should continue recursion
-						auto loadAfterCachedSave = loadTracker[adhocLevel].lower_bound(cachedSave->first);
+						auto loadAfterCachedSave = loadTracker[adhocLevel].lower_bound(cachedSaveFrame);
 						if (loadAfterCachedSave != loadTracker[adhocLevel].end() && *loadAfterCachedSave < frame)
-							bestSave = cachedSave->second;
+							bestSave = cachedSave;
 						else
-							return cachedSave->second;
+							return cachedSave;
 					}
 				}
 				else
 				{
-					saveCache[adhocLevel].erase(cachedSave->first); // Delete stale cached save
+					saveCache[adhocLevel].Erase(cachedSaveFrame); // Delete stale cached save
 					continue;
 				}
 			}
@@ -526,7 +624,10 @@ SaveMetadata<TResource> Script<TResource>::GetLatestSaveAndCache(int64_t frame)
 template <derived_from_specialization_of<Resource> TResource>
 void Script<TResource>::Load(uint64_t frame)
 {
+	uint64_t nFrameAdvancesStart = BaseStatus[_adhocLevel].nFrameAdvances;
+	uint64_t nLoadsStart = BaseStatus[_adhocLevel].nLoads;
 	LoadBase(frame, false);
+	ChargeBudget(BaseStatus[_adhocLevel].nFrameAdvances - nFrameAdvancesStart, BaseStatus[_adhocLevel].nLoads - nLoadsStart);
 }
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -536,6 +637,9 @@ void Script<TResource>::LongLoad(int64_t frame)
 	if (currentFrame == frame)
 		return;
 
+	uint64_t nFrameAdvancesStart = BaseStatus[_adhocLevel].nFrameAdvances;
+	uint64_t nLoadsStart = BaseStatus[_adhocLevel].nLoads;
+
 	// Load most recent save at or before frame. Check child saves before
 	// parent. If target frame is in future, check if faster to frame advance or load.
 	// Also, don't cache as it is unlikely the save will be needed again.
@@ -548,8 +652,31 @@ void Script<TResource>::LongLoad(int64_t frame)
 	else if (latestSave.frame > frame && resource->shouldLoad(latestSave.frame - currentFrame))
 		resource->LoadState(latestSave.GetSlotHandle()->slotId);
 
+	// Check the on-disk cache for a later state with the same inputs. Only valid if the resource started from power-on.
+	currentFrame = GetCurrentFrame();
+	bool useCheckpointCache = resource->IsCheckpointCacheEnabled() && resource->initialFrame == 0 && currentFrame < frame;
+	if (useCheckpointCache)
+	{
+		const std::vector<uint64_t>& hashes = GetInputsHashes(frame);
+		int64_t cachedFrame = resource->FindCachedCheckpoint(hashes, currentFrame + 1, frame);
+		if (cachedFrame != -1 && resource->shouldLoad(cachedFrame - currentFrame))
+		{
+			auto result = resource->LoadCachedCheckpoint(cachedFrame, hashes[cachedFrame]);
+			if (result != CachedCheckpointLoad::Unreadable)
+				BaseStatus[_adhocLevel].nLoads++;
+
+			// Fall back to the in-memory save if the cached state turns out to be for another frame
+			if (result == CachedCheckpointLoad::WrongFrame)
+			{
+				resource->LoadState(latestSave.GetSlotHandle()->slotId);
+				BaseStatus[_adhocLevel].nLoads++;
+			}
+		}
+	}
+
 	// If save is before target frame, play back until frame is reached
 	currentFrame = GetCurrentFrame();
+	bool replayed = currentFrame < frame;
 	while (currentFrame < frame)
 	{
 		// Advance frame
@@ -559,11 +686,17 @@ void Script<TResource>::LongLoad(int64_t frame)
 		currentFrame++;
 	}
 
+	// Spare future runs the replay
+	if (useCheckpointCache && replayed)
+		resource->SaveCachedCheckpoint(frame, GetInputsHashes(frame)[frame]);
+
 	// Resume state tracking
-	_rootScript->TrackState(this, GetInputsMetadataAndCache(frame));
+	UpdateTrackedState(frame);
 
 	// Create a save as it is likely that very many frames were advanced since the most recent one.
 	Save();
+
+	ChargeBudget(BaseStatus[_adhocLevel].nFrameAdvances - nFrameAdvancesStart, BaseStatus[_adhocLevel].nLoads - nLoadsStart);
 }
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -586,46 +719,120 @@ void Script<TResource>::LoadBase(uint64_t frame, bool desync)
 
 	// Run custom state tracker
 	currentFrame = GetCurrentFrame();
-	_rootScript->TrackState(this, GetInputsMetadataAndCache(currentFrame));
+	UpdateTrackedState(currentFrame);
+
+	// If checkpoints are scheduled, place them so the replayed range can be revisited in reverse efficiently
+	std::vector<int64_t> checkpointFrames;
+	if (_checkpointMemBudget > 0 && currentFrame < frame)
+		checkpointFrames = GetScheduledCheckpointFrames(currentFrame, frame);
+	auto nextCheckpoint = checkpointFrames.begin();
 
 	// If save is before target frame, play back until frame is reached
 	uint64_t frameCounter = 0;
 	while (currentFrame++ < frame)
 	{
-		AdvanceFrameRead();
+		AdvanceFrameReadBase();
 
 		auto cachedInputs = GetInputsMetadataAndCache(currentFrame);
 		frameCounter += IncrementFrameCounter(cachedInputs);
 
+		bool isCheckpoint = nextCheckpoint != checkpointFrames.end() && *nextCheckpoint == static_cast<int64_t>(currentFrame);
+
 		//Estimate future frame advances from aggregate of historical frame advances on this input segment
 		//If it reaches a certain threshold, creating a save is performant
-		if (resource->shouldSave(frameCounter))
+		if (isCheckpoint || resource->shouldSave(frameCounter))
 		{
-			SaveMetadata<TResource> cachedSave = cachedInputs.stateOwner->Save(cachedInputs.stateOwnerAdhocLevel);
-			saveCache[_adhocLevel][currentFrame] = cachedSave;
+			saveCache[_adhocLevel][currentFrame] = isCheckpoint
+				? SaveScheduledCheckpoint(cachedInputs)
+				: cachedInputs.stateOwner->Save(cachedInputs.stateOwnerAdhocLevel);
 			frameCounter = 0;
+
+			if (isCheckpoint)
+				nextCheckpoint++;
 		}
 	}
 }
 
+// Checkpoint frames for a replay from startFrame to endFrame, given the checkpoints still in use and the memory budget
+template <derived_from_specialization_of<Resource> TResource>
+std::vector<int64_t> Script<TResource>::GetScheduledCheckpointFrames(int64_t startFrame, int64_t endFrame)
+{
+	// Checkpoints past the target are not revisited by a backward sweep, so free their saves.
+	// A save on the same frame that has since replaced the checkpoint's is left alone.
+	for (auto checkpoint = scheduledCheckpoints.upper_bound(endFrame); checkpoint != scheduledCheckpoints.end();)
+	{
+		auto& [save, slotId] = checkpoint->second;
+		if (save.IsValid() && save.GetSlotHandle()->slotId == slotId)
+			save.script->DeleteSave(save.frame, save.adhocLevel);
+
+		checkpoint = scheduledCheckpoints.erase(checkpoint);
+	}
+
+	// Checkpoints the slot manager evicted no longer count against the budget
+	for (auto checkpoint = scheduledCheckpoints.begin(); checkpoint != scheduledCheckpoints.end();)
+	{
+		if (checkpoint->second.first.IsValid())
+			checkpoint++;
+		else
+			checkpoint = scheduledCheckpoints.erase(checkpoint);
+	}
+
+	// Checkpoints past the resource's save memory would only evict each other
+	int64_t stateSize = resource->GetEstimatedStateSize();
+	int64_t memBudget = (std::min)(_checkpointMemBudget, resource->GetSaveMemLimit());
+	int64_t maxCheckpoints = stateSize > 0 ? memBudget / stateSize : 0;
+	int64_t nFreeCheckpoints = maxCheckpoints - static_cast<int64_t>(scheduledCheckpoints.size());
+	if (nFreeCheckpoints <= 0)
+		return std::vector<int64_t>();
+
+	return CheckpointSchedule::GetCheckpointFrames(startFrame, endFrame, nFreeCheckpoints);
+}
+
+// Save the current frame as a scheduled checkpoint. If a save is already there, it is reused but not recorded,
+// so the schedule never deletes saves it didn't create.
+template <derived_from_specialization_of<Resource> TResource>
+SaveMetadata<TResource> Script<TResource>::SaveScheduledCheckpoint(const InputsMetadata<TResource>& inputsMetadata)
+{
+	Script<TResource>* stateOwner = inputsMetadata.stateOwner;
+	int64_t currentFrame = GetCurrentFrame();
+	bool created = !stateOwner->saveBank[inputsMetadata.stateOwnerAdhocLevel].Contains(currentFrame);
+
+	SaveMetadata<TResource> save = stateOwner->Save(inputsMetadata.stateOwnerAdhocLevel);
+	if (created && save.IsValid())
+		scheduledCheckpoints[currentFrame] = std::make_pair(save, save.GetSlotHandle()->slotId);
+
+	return save;
+}
+
+// Add binomial checkpoints to the cost-based saves for this script, within the given save memory budget.
+// Useful for scripts that sweep backwards over a frame range, e.g. loading frames from last to first.
+// Checkpoints past a replay target are deleted, since a backward sweep never returns to them.
+template <derived_from_specialization_of<Resource> TResource>
+void Script<TResource>::EnableCheckpointSchedule(int64_t saveMemBudget)
+{
+	_checkpointMemBudget = saveMemBudget;
+}
+
+template <derived_from_specialization_of<Resource> TResource>
+void Script<TResource>::DisableCheckpointSchedule()
+{
+	_checkpointMemBudget = 0;
+	scheduledCheckpoints.clear();
+}
+
 // Load method specifically for Script.Execute() and Script.Modify(), checks for desyncs
 template <derived_from_specialization_of<Resource> TResource>
-void Script<TResource>::Revert(uint64_t frame, const M64Diff& m64, std::map<int64_t, SlotHandle<TResource>>& childSaveBank, Script<TResource>* childScript)
+void Script<TResource>::Revert(uint64_t frame, const M64Diff& m64, FrameCache<SlotHandle<TResource>>& childSaveBank, Script<TResource>* childScript)
 {
 	// Check if script altered state
 	bool desync = (!m64.frames.empty()) && (m64.frames.begin()->first < GetCurrentFrame());
 
-	auto lastSyncedSave = childSaveBank.end();
-	if (!m64.frames.empty() && !childSaveBank.empty())
-	{
-		auto firstDesyncedSave = childSaveBank.upper_bound(m64.frames.begin()->first);
-		if (firstDesyncedSave != childSaveBank.begin())
-			lastSyncedSave = std::prev(firstDesyncedSave);
-	}
+	//Saves up to and including the first frame of the diff are unaffected by it
+	int64_t lastSyncedFrame = m64.frames.empty() ? INT64_MAX : m64.frames.begin()->first;
 
 	//Move child saves to parent that are not desynced
 	//If child is ad-hoc script, pop the save bank
-	std::move(childSaveBank.begin(), lastSyncedSave, std::insert_iterator(saveBank[_adhocLevel], saveBank[_adhocLevel].end()));
+	childSaveBank.MoveInto(saveBank[_adhocLevel], lastSyncedFrame);
 	if (saveBank.contains(_adhocLevel + 1))
 		saveBank.erase(_adhocLevel + 1);
 
@@ -648,11 +855,7 @@ void Script<TResource>::Rollback(uint64_t frame)
 			BaseStatus[_adhocLevel].m64Diff.frames.lower_bound(frame),
 			BaseStatus[_adhocLevel].m64Diff.frames.end());
 
-		inputsCache[_adhocLevel].erase(inputsCache[_adhocLevel].lower_bound(firstFrame), inputsCache[_adhocLevel].end());
-		frameCounter[_adhocLevel].erase(frameCounter[_adhocLevel].upper_bound(firstFrame), frameCounter[_adhocLevel].end());
-		saveBank[_adhocLevel].erase(saveBank[_adhocLevel].upper_bound(firstFrame), saveBank[_adhocLevel].end());
-		saveCache[_adhocLevel].erase(saveCache[_adhocLevel].upper_bound(firstFrame), saveCache[_adhocLevel].end());
-		_rootScript->EraseTrackedStates(this, _adhocLevel, firstFrame);
+		InvalidateCaches(firstFrame);
 	}
 
 	//Desyncs should be impossible for rollback because no inputs are changed prior to frame being loaded
@@ -679,11 +882,7 @@ void Script<TResource>::RollForward(int64_t frame)
 
 		BaseStatus[_adhocLevel].m64Diff.frames.erase(BaseStatus[_adhocLevel].m64Diff.frames.begin(), inputsUpperBound);
 
-		inputsCache[_adhocLevel].erase(inputsCache[_adhocLevel].lower_bound(firstFrame), inputsCache[_adhocLevel].end());
-		frameCounter[_adhocLevel].erase(frameCounter[_adhocLevel].upper_bound(firstFrame), frameCounter[_adhocLevel].end());
-		saveBank[_adhocLevel].erase(saveBank[_adhocLevel].upper_bound(firstFrame), saveBank[_adhocLevel].end());
-		saveCache[_adhocLevel].erase(saveCache[_adhocLevel].upper_bound(firstFrame), saveCache[_adhocLevel].end());
-		_rootScript->EraseTrackedStates(this, _adhocLevel, firstFrame);
+		InvalidateCaches(firstFrame);
 	}
 
 	LoadBase(frame, desync);
@@ -705,11 +904,7 @@ void Script<TResource>::Restore(int64_t frame)
 			BaseStatus[_adhocLevel].m64Diff.frames.lower_bound(frame),
 			BaseStatus[_adhocLevel].m64Diff.frames.end());
 
-		inputsCache[_adhocLevel].erase(inputsCache[_adhocLevel].lower_bound(firstFrame), inputsCache[_adhocLevel].end());
-		frameCounter[_adhocLevel].erase(frameCounter[_adhocLevel].upper_bound(firstFrame), frameCounter[_adhocLevel].end());
-		saveBank[_adhocLevel].erase(saveBank[_adhocLevel].upper_bound(firstFrame), saveBank[_adhocLevel].end());
-		saveCache[_adhocLevel].erase(saveCache[_adhocLevel].upper_bound(firstFrame), saveCache[_adhocLevel].end());
-		_rootScript->EraseTrackedStates(this, _adhocLevel, firstFrame);
+		InvalidateCaches(firstFrame);
 	}
 
 	LoadBase(frame, desync);
@@ -728,13 +923,12 @@ template <derived_from_specialization_of<Resource> TResource>
 SaveMetadata<TResource> Script<TResource>::Save(int64_t adhocLevel)
 {
 	//Desyncs should always clear future saves, so if a save already exists there is no need to overwrite it
+	//Release stale saves in one batch before taking up more save memory
 	int64_t currentFrame = GetCurrentFrame();
-	if (!saveBank[adhocLevel].contains(currentFrame))
+	saveBank[adhocLevel].Reclaim();
+	if (!saveBank[adhocLevel].Contains(currentFrame))
 	{
-		saveBank[adhocLevel].emplace(
-			std::piecewise_construct,
-			std::forward_as_tuple(currentFrame),
-			std::forward_as_tuple(resource, resource->SaveState()));
+		saveBank[adhocLevel].Emplace(currentFrame, resource, resource->SaveState());
 		BaseStatus[adhocLevel].nSaves++;
 	}
 
@@ -750,6 +944,21 @@ void Script<TResource>::OptionalSave()
 	//Integrate frame counter, saving only if threshold is reached
 	int64_t currentFrame = GetCurrentFrame();
 	int64_t latestSaveFrame = GetLatestSaveAndCache(currentFrame).frame;
+
+	//If checkpoints are scheduled, plan over the furthest frame revisited so far and save once the first planned checkpoint is passed.
+	//Otherwise fall back to the cost-benefit analysis
+	if (_checkpointMemBudget > 0)
+	{
+		int64_t horizon = (std::max)(currentFrame, frameCounter[_adhocLevel].GetLatestFrame(INT64_MAX));
+
+		auto checkpointFrames = GetScheduledCheckpointFrames(latestSaveFrame, horizon);
+		if (!checkpointFrames.empty() && checkpointFrames[0] <= currentFrame)
+		{
+			saveCache[_adhocLevel][currentFrame] = SaveScheduledCheckpoint(GetInputsMetadata(currentFrame));
+			return;
+		}
+	}
+
 	uint64_t frameCounter = 0;
 	for (int64_t frame = latestSaveFrame + 1; frame <= currentFrame; frame++)
 	{
@@ -769,7 +978,7 @@ void Script<TResource>::OptionalSave()
 template <derived_from_specialization_of<Resource> TResource>
 void Script<TResource>::DeleteSave(int64_t frame, int64_t adhocLevel)
 {
-	saveBank[adhocLevel].erase(frame);
+	saveBank[adhocLevel].Erase(frame);
 }
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -843,7 +1052,7 @@ AdhocScriptStatus<TAdhocCustomScriptStatus> Script<TResource>::ExecuteAdhoc(F ad
 	int64_t initialFrame = GetCurrentFrame();
 
 	TAdhocCustomScriptStatus customStatus = TAdhocCustomScriptStatus();
-	BaseScriptStatus baseStatus = ExecuteAdhocBase([&]() { return adhocScript(customStatus); });
+	BaseScriptStatus baseStatus = ExecuteAdhocBase([&]() { return adhocScript(customStatus); }, typeid(F));
 	Revert(initialFrame, baseStatus.m64Diff, saveBank[_adhocLevel + 1], this);
 
 	return AdhocScriptStatus<TAdhocCustomScriptStatus>(baseStatus, customStatus);
@@ -867,12 +1076,36 @@ AdhocScriptStatus<TAdhocCustomScriptStatus> Script<TResource>::ModifyAdhoc(F adh
 	int64_t initialFrame = GetCurrentFrame();
 
 	TAdhocCustomScriptStatus customStatus = TAdhocCustomScriptStatus();
-	BaseScriptStatus baseStatus = ExecuteAdhocBase([&]() { return adhocScript(customStatus); });
+	BaseScriptStatus baseStatus = ExecuteAdhocBase([&]() { return adhocScript(customStatus); }, typeid(F));
 	ApplyChildDiff(baseStatus, saveBank[_adhocLevel + 1], initialFrame, this);
 
 	return AdhocScriptStatus<TAdhocCustomScriptStatus>(baseStatus, customStatus);
 }
 
+template <derived_from_specialization_of<Resource> TResource>
+AdhocBaseScriptStatus Script<TResource>::ExecuteAdhoc(const ScriptBudget& budget, AdhocScript auto adhocScript)
+{
+	ScriptBudgetScope* parentBudgetScope = _budgetScope;
+	ScriptBudgetScope budgetScope(budget, parentBudgetScope);
+	_budgetScope = &budgetScope;
+	auto status = ExecuteAdhoc(adhocScript);
+	_budgetScope = parentBudgetScope;
+
+	return status;
+}
+
+template <derived_from_specialization_of<Resource> TResource>
+AdhocBaseScriptStatus Script<TResource>::ModifyAdhoc(const ScriptBudget& budget, AdhocScript auto adhocScript)
+{
+	ScriptBudgetScope* parentBudgetScope = _budgetScope;
+	ScriptBudgetScope budgetScope(budget, parentBudgetScope);
+	_budgetScope = &budgetScope;
+	auto status = ModifyAdhoc(adhocScript);
+	_budgetScope = parentBudgetScope;
+
+	return status;
+}
+
 template <derived_from_specialization_of<Resource> TResource>
 template <AdhocScript TAdhocScript>
 AdhocBaseScriptStatus Script<TResource>::TestAdhoc(TAdhocScript&& adhocScript)
@@ -895,7 +1128,7 @@ AdhocScriptStatus<TAdhocCustomScriptStatus> Script<TResource>::TestAdhoc(F&& adh
 
 template <derived_from_specialization_of<Resource> TResource>
 template <typename F>
-BaseScriptStatus Script<TResource>::ExecuteAdhocBase(F adhocScript)
+BaseScriptStatus Script<TResource>::ExecuteAdhocBase(F adhocScript, const std::type_info& callSite)
 {
 	//Increment adhoc level
 	_adhocLevel++;
@@ -914,7 +1147,26 @@ BaseScriptStatus Script<TResource>::ExecuteAdhocBase(F adhocScript)
 	uint64_t advanceFrameTimeStart = resource->GetTotalFrameAdvanceTime();
 
 	auto start = std::chrono::high_resolution_clock::now();
-	BaseStatus[_adhocLevel].executed = adhocScript();
+	{
+		BaseScriptStatus& baseStatus = BaseStatus[_adhocLevel];
+		ScriptProfiler::Scope profilerScope = ScriptProfiler::Scope(callSite, true, baseStatus.nFrameAdvances, baseStatus.nSaves, baseStatus.nLoads);
+		if (_budgetScope && _budgetScope->IsExceeded())
+			baseStatus.budgetExceeded = true;
+		else
+		{
+			// Frame advances and loads throw once a budget is used up, unwinding to the innermost adhoc script.
+			// Its changes are reverted by the caller like any other failed adhoc script.
+			try
+			{
+				baseStatus.executed = adhocScript();
+			}
+			catch (const ScriptBudgetExceeded&)
+			{
+				baseStatus.executed = false;
+				baseStatus.budgetExceeded = true;
+			}
+		}
+	}
 	auto finish = std::chrono::high_resolution_clock::now();
 
 	BaseStatus[_adhocLevel].loadDuration = resource->GetTotalLoadStateTime() - loadStateTimeStart;
@@ -935,12 +1187,14 @@ BaseScriptStatus Script<TResource>::ExecuteAdhocBase(F adhocScript)
 	frameCounter.erase(_adhocLevel);
 	saveCache.erase(_adhocLevel);
 	inputsCache.erase(_adhocLevel);
+	inputsHashes.erase(_adhocLevel);
 	loadTracker.erase(_adhocLevel);
 	_adhocLevel--;
 
 	BaseStatus[_adhocLevel].nLoads += status.nLoads;
 	BaseStatus[_adhocLevel].nSaves += status.nSaves;
 	BaseStatus[_adhocLevel].nFrameAdvances += status.nFrameAdvances;
+	BaseStatus[_adhocLevel].nAborts += status.nAborts;
 
 	return status;
 }
@@ -957,10 +1211,7 @@ SlotHandle<TResource>* SaveMetadata<TResource>::GetSlotHandle()
 	if (script->saveBank.size() <= static_cast<uint64_t>(adhocLevel))
 		return nullptr;
 
-	if (!script->saveBank[adhocLevel].contains(frame))
-		return nullptr;
-
-	return &script->saveBank[adhocLevel].find(frame)->second;
+	return script->saveBank[adhocLevel].Find(frame);
 }
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -972,7 +1223,7 @@ bool SaveMetadata<TResource>::IsValid()
 
 	if (!slotHandle->isValid())
 	{
-		script->saveBank[adhocLevel].erase(frame);
+		script->saveBank[adhocLevel].Erase(frame);
 		return false;
 	}
 
@@ -980,41 +1231,139 @@ bool SaveMetadata<TResource>::IsValid()
 }
 
 template <derived_from_specialization_of<Resource> TResource, std::derived_from<Script<TResource>> TStateTracker>
-void TopLevelScript<TResource, TStateTracker>::TrackState(Script<TResource>* currentScript, const InputsMetadata<TResource>& inputsMetadata)
+void TopLevelScript<TResource, TStateTracker>::TrackState(Script<TResource>* currentScript, int64_t frame)
 {
 	if constexpr (std::is_same<TStateTracker, DefaultStateTracker<TResource>>::value)
 		return;
 
-	if (!ScriptFriend<TResource>::IsStateTracker(currentScript))
+	if (ScriptFriend<TResource>::IsStateTracker(currentScript))
+		return;
+
+	auto inputsMetadata = ScriptFriend<TResource>::GetInputsMetadataAndCache(currentScript, frame);
+	if constexpr (StreamingStateTracker<TStateTracker>)
+	{
+		if (!TrackedStateExistsInternal(currentScript, inputsMetadata) && !StreamTrackedState(currentScript, inputsMetadata))
+			GetTrackedStateInternal(currentScript, inputsMetadata);
+	}
+	else
 		GetTrackedStateInternal(currentScript, inputsMetadata);
+
+	EnforceTrackedStateBudget();
+}
+
+// Compute the state on the current frame directly from the previous frame's state. No script hierarchy is built and nothing is loaded.
+// Returns false if the previous state is not tracked, e.g. after a rollback, in which case the regular tracker back-fills it.
+// Frames the tracker doesn't build on the previous state, such as its first frame, start from the default state like they do in execution().
+// Like ExecuteStateTracker, a new tracker runs under the current script, so adhoc work in advance loads through that script's saves and inputs.
+template <derived_from_specialization_of<Resource> TResource, std::derived_from<Script<TResource>> TStateTracker>
+bool TopLevelScript<TResource, TStateTracker>::StreamTrackedState(Script<TResource>* currentScript, const InputsMetadata<TResource>& inputsMetadata)
+{
+	if constexpr (StreamingStateTracker<TStateTracker>)
+	{
+		static const typename TStateTracker::CustomScriptStatus defaultState = typename TStateTracker::CustomScriptStatus();
+
+		TStateTracker stateTracker = stateTrackerFactory->Generate();
+		ScriptFriend<TResource>::Initialize(&stateTracker, currentScript);
+		ScriptFriend<TResource>::SetBudgetScope(&stateTracker, nullptr); // State tracking is bookkeeping, not work done by the script
+		ScriptFriend<TResource>::SetIsStateTracker(&stateTracker, true);
+
+		const typename TStateTracker::CustomScriptStatus* previousState = &defaultState;
+		bool streamed = true;
+		if (stateTracker.HasPreviousState())
+		{
+			auto previousMetadata = ScriptFriend<TResource>::GetInputsMetadataAndCache(currentScript, inputsMetadata.frame - 1);
+			previousState = trackedStates[previousMetadata.stateOwner][previousMetadata.stateOwnerAdhocLevel].Find(previousMetadata.frame);
+			streamed = previousState != nullptr;
+		}
+
+		auto state = typename TStateTracker::CustomScriptStatus();
+		if (streamed
+			&& ScriptFriend<TResource>::Validate(&stateTracker)
+			&& stateTracker.advance(*previousState)
+			&& ScriptFriend<TResource>::Assert(&stateTracker))
+		{
+			state = std::move(stateTracker.CustomStatus);
+		}
+
+		bool desynced = !ScriptFriend<TResource>::GetBaseStatus(&stateTracker)[0].m64Diff.frames.empty();
+		ScriptFriend<TResource>::DisposeSlotHandles(&stateTracker);
+		PopTrackedStatesContainer(&stateTracker, 0);
+		if (desynced)
+			throw std::runtime_error("Streaming state tracker changed inputs outside of an adhoc script");
+
+		if (streamed)
+			SetTrackedState(inputsMetadata, std::move(state));
+
+		return streamed;
+	}
+
+	return false;
 }
 
 template <derived_from_specialization_of<Resource> TResource, std::derived_from<Script<TResource>> TStateTracker>
 bool TopLevelScript<TResource, TStateTracker>::TrackedStateExistsInternal(Script<TResource>* currentScript, const InputsMetadata<TResource>& inputsMetadata)
 {
-	return trackedStates[inputsMetadata.stateOwner][inputsMetadata.stateOwnerAdhocLevel].contains(inputsMetadata.frame);
+	return trackedStates[inputsMetadata.stateOwner][inputsMetadata.stateOwnerAdhocLevel].Find(inputsMetadata.frame) != nullptr;
 }
 
 template <derived_from_specialization_of<Resource> TResource, std::derived_from<Script<TResource>> TStateTracker>
-typename TStateTracker::CustomScriptStatus TopLevelScript<TResource, TStateTracker>
+const typename TStateTracker::CustomScriptStatus& TopLevelScript<TResource, TStateTracker>
 	::GetTrackedStateInternal(Script<TResource>* currentScript, const InputsMetadata<TResource>& inputsMetadata)
 {
+	static const typename TStateTracker::CustomScriptStatus defaultState = typename TStateTracker::CustomScriptStatus();
 	if constexpr (std::is_same<TStateTracker, DefaultStateTracker<TResource>>::value)
-		return typename TStateTracker::CustomScriptStatus();
+		return defaultState;
 
-	if (trackedStates[inputsMetadata.stateOwner][inputsMetadata.stateOwnerAdhocLevel].contains(inputsMetadata.frame))
-		return trackedStates[inputsMetadata.stateOwner][inputsMetadata.stateOwnerAdhocLevel][inputsMetadata.frame];
-
-	uint64_t currentFrame = ScriptFriend<TResource>::GetCurrentFrame(currentScript);
+	auto trackedState = trackedStates[inputsMetadata.stateOwner][inputsMetadata.stateOwnerAdhocLevel].Find(inputsMetadata.frame);
+	if (trackedState)
+		return *trackedState;
 
 	auto status = ScriptFriend<TResource>::ExecuteStateTracker<TStateTracker>(inputsMetadata.frame, currentScript, stateTrackerFactory);
 	auto state = typename TStateTracker::CustomScriptStatus();
 	if (status.asserted)
-		state = (typename TStateTracker::CustomScriptStatus)status;
+		state = std::move(static_cast<typename TStateTracker::CustomScriptStatus&>(status));
+
+	return SetTrackedState(inputsMetadata, std::move(state));
+}
 
-	trackedStates[inputsMetadata.stateOwner][inputsMetadata.stateOwnerAdhocLevel][inputsMetadata.frame] = state;
+template <derived_from_specialization_of<Resource> TResource, std::derived_from<Script<TResource>> TStateTracker>
+const typename TStateTracker::CustomScriptStatus& TopLevelScript<TResource, TStateTracker>
+	::SetTrackedState(const InputsMetadata<TResource>& inputsMetadata, typename TStateTracker::CustomScriptStatus&& state)
+{
+	auto& trackedStateBuffer = trackedStates[inputsMetadata.stateOwner][inputsMetadata.stateOwnerAdhocLevel];
+	uint64_t previousMemoryUsage = trackedStateBuffer.GetMemoryUsage();
+	auto& trackedState = trackedStateBuffer.Set(inputsMetadata.frame, std::move(state));
+	RecordTrackedStateMemory(previousMemoryUsage, trackedStateBuffer.GetMemoryUsage());
 
-	return state;
+	return trackedState;
+}
+
+template <derived_from_specialization_of<Resource> TResource, std::derived_from<Script<TResource>> TStateTracker>
+void TopLevelScript<TResource, TStateTracker>::RecordTrackedStateMemory(uint64_t previousMemoryUsage, uint64_t memoryUsage)
+{
+	trackedStateMemory = trackedStateMemory + memoryUsage - previousMemoryUsage;
+	peakTrackedStateMemory = std::max(peakTrackedStateMemory, trackedStateMemory);
+}
+
+// Evict older states from every buffer once the budget is exceeded. If the remaining states alone exceed the budget,
+// wait for memory to grow by a quarter of the budget before trying again, so that eviction isn't attempted on every frame.
+template <derived_from_specialization_of<Resource> TResource, std::derived_from<Script<TResource>> TStateTracker>
+void TopLevelScript<TResource, TStateTracker>::EnforceTrackedStateBudget()
+{
+	if (trackedStateBudget.maxMemory == 0 || trackedStateMemory <= std::max(trackedStateBudget.maxMemory, trackedStateEvictionThreshold))
+		return;
+
+	for (auto& [script, adhocLevels] : trackedStates)
+	{
+		for (auto& [adhocLevel, trackedStateBuffer] : adhocLevels)
+		{
+			uint64_t previousMemoryUsage = trackedStateBuffer.GetMemoryUsage();
+			nEvictedTrackedStates += trackedStateBuffer.Evict(trackedStateBudget);
+			RecordTrackedStateMemory(previousMemoryUsage, trackedStateBuffer.GetMemoryUsage());
+		}
+	}
+
+	trackedStateEvictionThreshold = trackedStateMemory + trackedStateBudget.maxMemory / 4;
 }
 
 template <derived_from_specialization_of<Resource> TResource, std::derived_from<Script<TResource>> TStateTracker>
@@ -1033,9 +1382,17 @@ void TopLevelScript<TResource, TStateTracker>::PopTrackedStatesContainer(Script<
 		return;
 
 	if (adhocLevel == 0)
+	{
+		for (auto& [level, trackedStateBuffer] : trackedStates[currentScript])
+			RecordTrackedStateMemory(trackedStateBuffer.GetMemoryUsage(), 0);
+
 		trackedStates.erase(currentScript);
+	}
 	else
+	{
+		RecordTrackedStateMemory(trackedStates[currentScript][adhocLevel].GetMemoryUsage(), 0);
 		trackedStates[currentScript].erase(adhocLevel);
+	}
 }
 
 template <derived_from_specialization_of<Resource> TResource, std::derived_from<Script<TResource>> TStateTracker>
@@ -1044,12 +1401,18 @@ void TopLevelScript<TResource, TStateTracker>::MoveSyncedTrackedStates(Script<TR
 	if constexpr (std::is_same<TStateTracker, DefaultStateTracker<TResource>>::value)
 		return;
 
-	std::move(trackedStates[sourceScript][sourceAdhocLevel].begin(), trackedStates[sourceScript][sourceAdhocLevel].end(),
-		std::insert_iterator(trackedStates[destScript][destAdhocLevel], trackedStates[destScript][destAdhocLevel].end()));
+	auto& sourceBuffer = trackedStates[sourceScript][sourceAdhocLevel];
+	auto& destBuffer = trackedStates[destScript][destAdhocLevel];
+	uint64_t previousMemoryUsage = sourceBuffer.GetMemoryUsage() + destBuffer.GetMemoryUsage();
+	sourceBuffer.MoveInto(destBuffer);
+	RecordTrackedStateMemory(previousMemoryUsage, sourceBuffer.GetMemoryUsage() + destBuffer.GetMemoryUsage());
 
 	// If source was an ad-hoc script, pop the save bank
 	if (trackedStates[destScript].contains(destAdhocLevel + 1))
+	{
+		RecordTrackedStateMemory(trackedStates[destScript][destAdhocLevel + 1].GetMemoryUsage(), 0);
 		trackedStates[destScript].erase(destAdhocLevel + 1);
+	}
 }
 
 template <derived_from_specialization_of<Resource> TResource, std::derived_from<Script<TResource>> TStateTracker>
@@ -1058,8 +1421,77 @@ void TopLevelScript<TResource, TStateTracker>::EraseTrackedStates(Script<TResour
 	if constexpr (std::is_same<TStateTracker, DefaultStateTracker<TResource>>::value)
 		return;
 
-	trackedStates[currentScript][adhocLevel].erase(
-		trackedStates[currentScript][adhocLevel].upper_bound(firstFrame), trackedStates[currentScript][adhocLevel].end());
+	auto& trackedStateBuffer = trackedStates[currentScript][adhocLevel];
+	uint64_t previousMemoryUsage = trackedStateBuffer.GetMemoryUsage();
+	trackedStateBuffer.Erase(firstFrame + 1);
+	RecordTrackedStateMemory(previousMemoryUsage, trackedStateBuffer.GetMemoryUsage());
+}
+
+template <derived_from_specialization_of<Resource> TResource>
+template <class TStateTracker>
+auto ScriptCompareHelper<TResource>::GetStateTrackerFactory()
+{
+	auto root = dynamic_cast<TopLevelScript<TResource, TStateTracker>*>(script->_rootScript);
+	if (!root)
+		throw std::runtime_error("Parallel compare state tracker does not match the top-level script");
+
+	return root->stateTrackerFactory;
+}
+
+template <derived_from_specialization_of<Resource> TResource>
+template <class TScript, class TStateTracker, typename TTuple>
+std::vector<ScriptStatus<TScript>> ScriptCompareHelper<TResource>::ExecuteParallel(ResourcePool<TResource>& resourcePool, const std::vector<TTuple>& paramsList)
+{
+	std::vector<ScriptStatus<TScript>> statuses(paramsList.size());
+	if (paramsList.empty())
+		return statuses;
+
+	if (resourcePool.Size() == 0)
+		throw std::runtime_error("Parallel compare requires at least one pooled resource");
+
+	// Saved states hold pointers into the resource that made them, so another resource can't start from an imported save.
+	// Workers have to replay from power-on instead, which needs every input since then.
+	if (script->resource->initialFrame != 0)
+		throw std::runtime_error("Parallel compare is not supported from an imported save");
+
+	auto stateTrackerFactory = GetStateTrackerFactory<TStateTracker>();
+
+	// Workers replay the inputs from power-on up to the current frame
+	int64_t baseFrame = script->GetCurrentFrame();
+	M64 m64;
+	m64.frames = script->GetInputs(0, baseFrame - 1).frames;
+
+	int64_t nWorkers = std::min(resourcePool.Size(), static_cast<int64_t>(paramsList.size()));
+	std::atomic<int64_t> nextCandidate = 0;
+	std::vector<std::exception_ptr> exceptions(nWorkers);
+
+	#pragma omp parallel for num_threads(nWorkers)
+	for (int64_t worker = 0; worker < nWorkers; worker++)
+	{
+		// Under nested parallelism the workers run one after another, and later ones may find nothing left to do
+		if (nextCandidate.load() >= static_cast<int64_t>(paramsList.size()))
+			continue;
+
+		try
+		{
+			TResource* resource = resourcePool.Get(worker);
+			using TWorker = ParallelCompareWorker<TResource, TStateTracker, TScript, TTuple>;
+			TopLevelScript<TResource, TStateTracker>::template MainImportShared<TWorker>(
+				m64, stateTrackerFactory, resource, baseFrame, paramsList, statuses, nextCandidate);
+		}
+		catch (...)
+		{
+			exceptions[worker] = std::current_exception();
+		}
+	}
+
+	for (const std::exception_ptr& exception : exceptions)
+	{
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+
+	return statuses;
 }
 
 #endif
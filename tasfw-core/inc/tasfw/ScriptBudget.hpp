@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+
+#ifndef SCRIPT_BUDGET_H
+#define SCRIPT_BUDGET_H
+
+/// <summary>
+/// Limits on the work a script subtree may do. A limit of 0 means unlimited.
+/// </summary>
+class ScriptBudget
+{
+public:
+	uint64_t maxFrameAdvances = 0;
+	uint64_t maxLoads = 0;
+	uint64_t maxDuration = 0; // Wall-clock nanoseconds
+
+	ScriptBudget() = default;
+
+	bool IsUnlimited() const;
+};
+
+/// <summary>
+/// Thrown by frame advances and loads once a budget is used up. Caught by the innermost adhoc script,
+/// which then fails with budgetExceeded set, so it never propagates out of a script.
+/// </summary>
+class ScriptBudgetExceeded : public std::runtime_error
+{
+public:
+	ScriptBudgetExceeded() : std::runtime_error("Script budget exceeded") {}
+};
+
+/// <summary>
+/// Tracks consumption against a budget for as long as a script or budgeted adhoc script runs.
+/// Scopes are chained to the scope of the enclosing script, so work is charged against every budget it falls under.
+/// </summary>
+class ScriptBudgetScope
+{
+public:
+	ScriptBudgetScope(const ScriptBudget& budget, ScriptBudgetScope* parent);
+
+	ScriptBudgetScope(const ScriptBudgetScope&) = delete;
+	ScriptBudgetScope& operator= (const ScriptBudgetScope&) = delete;
+
+	ScriptBudgetScope* GetParent() const { return _parent; }
+
+	// Add to this scope and all enclosing scopes. Throws ScriptBudgetExceeded if any of them is over its budget.
+	void Charge(uint64_t nFrameAdvances, uint64_t nLoads);
+
+	// Whether this scope or an enclosing scope is over its budget
+	bool IsExceeded();
+
+private:
+	ScriptBudget _budget;
+	ScriptBudgetScope* _parent;
+	uint64_t _startTime;
+	uint64_t _nFrameAdvances = 0;
+	uint64_t _nLoads = 0;
+	bool _exceeded = false;
+
+	bool IsExceededLocal();
+	static uint64_t GetTime();
+};
+
+#endif
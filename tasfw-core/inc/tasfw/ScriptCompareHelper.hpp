@@ -1,6 +1,13 @@
 #pragma once
 #include <tasfw/ScriptStatus.hpp>
 #include <tasfw/SharedLib.hpp>
+#include <tasfw/InputTrie.hpp>
+#include <tasfw/ResourcePool.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <typeinfo>
 
 #ifndef SCRIPT_COMPARE_HELPER_H
 #define SCRIPT_COMPARE_HELPER_H
@@ -8,6 +15,9 @@
 template <derived_from_specialization_of<Resource> TResource>
 class Script;
 
+template <derived_from_specialization_of<Resource> TResource, class TStateTracker, class TScript, class TTuple>
+class ParallelCompareWorker;
+
 template <typename F>
 auto AdhocCompareScript_impl = [](auto... params) constexpr -> void
 {
@@ -73,6 +83,19 @@ public:
 	AdhocSubstatus(int64_t nMutations, AdhocScriptStatus<TCompareStatus> substatus) : nMutations(nMutations), substatus(substatus) { }
 };
 
+template <class TCompareStatus>
+class SearchSubstatus
+{
+public:
+	int64_t nEvaluations = 0; // Distinct parameters simulated. Revisited parameters are memoized.
+	int64_t param = 0; // Parameter of the best status
+	bool monotonic = true; // Whether evaluated points get no better moving away from the best. If not, the best may only be a local optimum.
+	AdhocScriptStatus<TCompareStatus> substatus;
+
+	SearchSubstatus(int64_t nEvaluations, int64_t param, bool monotonic, AdhocScriptStatus<TCompareStatus> substatus)
+		: nEvaluations(nEvaluations), param(param), monotonic(monotonic), substatus(substatus) { }
+};
+
 template <derived_from_specialization_of<Resource> TResource>
 class ScriptCompareHelper
 {
@@ -81,6 +104,20 @@ public:
 
     ScriptCompareHelper(Script<TResource>* script) : script(script) { }
 
+	// Best status so far of the compare currently running on this script, or nullptr if there is none yet or it has a different type
+	template <class TStatus>
+	const TStatus* GetIncumbent() const
+	{
+		if (!incumbent || *incumbentType != typeid(TStatus))
+			return nullptr;
+
+		const TStatus* status = static_cast<const TStatus*>(incumbent);
+		if constexpr (std::derived_from<TStatus, BaseScriptStatus>)
+			return status->asserted ? status : nullptr;
+		else
+			return status->executed ? status : nullptr;
+	}
+
 	template <class TScript,
 		class TTupleContainer,
 		typename TTuple = typename TTupleContainer::value_type,
@@ -90,6 +127,7 @@ public:
 	ScriptStatus<TScript> Compare(const TTupleContainer& paramsList, F&& comparator, G terminator)
 	{
 		ScriptStatus<TScript> status1 = ScriptStatus<TScript>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		int64_t iteration = 0;
 
 		// return if container is empty
@@ -130,6 +168,7 @@ public:
 	ScriptStatus<TScript> Compare(F&& paramsGenerator, G&& comparator, H terminator)
 	{
 		ScriptStatus<TScript> status1 = ScriptStatus<TScript>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		int64_t iteration = 0;
 		TTuple params;
 
@@ -162,6 +201,7 @@ public:
 	ScriptStatus<TScript> ModifyCompare(const TTupleContainer& paramsList, F&& comparator, G terminator)
 	{
 		ScriptStatus<TScript> status1 = ScriptStatus<TScript>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		ScriptStatus<TScript> status2 = ScriptStatus<TScript>();
 		int64_t iteration = 0;
 
@@ -232,6 +272,7 @@ public:
 	ScriptStatus<TScript> ModifyCompare(F&& paramsGenerator, G&& comparator, H terminator)
 	{
 		ScriptStatus<TScript> status1 = ScriptStatus<TScript>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		ScriptStatus<TScript> status2 = ScriptStatus<TScript>();
 		int64_t iteration = 0;
 		TTuple params;
@@ -302,6 +343,7 @@ public:
 	AdhocScriptStatus<Substatus<TScript>> DynamicCompare(const TTupleContainer& paramsList, F&& mutator, G&& comparator, H terminator)
 	{
 		ScriptStatus<TScript> status1 = ScriptStatus<TScript>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		int64_t iteration = 0;
 		int64_t nMutations = 0;
 		int64_t incumbentMutations = 0;
@@ -368,6 +410,7 @@ public:
 	AdhocScriptStatus<Substatus<TScript>> DynamicCompare(F&& paramsGenerator, G&& mutator, H&& comparator, I terminator)
 	{
 		ScriptStatus<TScript> status1 = ScriptStatus<TScript>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		int64_t iteration = 0;
 		int64_t nMutations = 0;
 		int64_t incumbentMutations = 0;
@@ -427,6 +470,7 @@ public:
 	AdhocScriptStatus<Substatus<TScript>> DynamicModifyCompare(const TTupleContainer& paramsList, F&& mutator, G&& comparator, H terminator)
 	{
 		ScriptStatus<TScript> status1 = ScriptStatus<TScript>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		ScriptStatus<TScript> status2 = ScriptStatus<TScript>();
 		int64_t iteration = 0;
 		int64_t nMutations = 0;
@@ -526,6 +570,7 @@ public:
 	AdhocScriptStatus<Substatus<TScript>> DynamicModifyCompare(F&& paramsGenerator, G&& mutator, H&& comparator, I terminator)
 	{
 		ScriptStatus<TScript> status1 = ScriptStatus<TScript>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		ScriptStatus<TScript> status2 = ScriptStatus<TScript>();
 		int64_t iteration = 0;
 		int64_t nMutations = 0;
@@ -623,6 +668,7 @@ public:
 	AdhocScriptStatus<TCompareStatus> CompareAdhoc(const TTupleContainer& paramsList, F&& adhocScript, G&& comparator, H terminator)
 	{
 		AdhocScriptStatus<TCompareStatus> status1 = AdhocScriptStatus<TCompareStatus>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		int64_t iteration = 0;
 
 		// return if container is empty
@@ -663,6 +709,7 @@ public:
 	AdhocScriptStatus<TCompareStatus> CompareAdhoc(F&& paramsGenerator, G&& adhocScript, H&& comparator, I terminator)
 	{
 		AdhocScriptStatus<TCompareStatus> status1 = AdhocScriptStatus<TCompareStatus>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		int64_t iteration = 0;
 		TTuple params;
 
@@ -695,6 +742,7 @@ public:
 	AdhocScriptStatus<TCompareStatus> ModifyCompareAdhoc(const TTupleContainer& paramsList, F&& adhocScript, G&& comparator, H terminator)
 	{
 		AdhocScriptStatus<TCompareStatus> status1 = AdhocScriptStatus<TCompareStatus>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		AdhocScriptStatus<TCompareStatus> status2 = AdhocScriptStatus<TCompareStatus>();
 		int64_t iteration = 0;
 
@@ -764,6 +812,7 @@ public:
 	AdhocScriptStatus<TCompareStatus> ModifyCompareAdhoc(F&& paramsGenerator, G&& adhocScript, H&& comparator, I terminator)
 	{
 		AdhocScriptStatus<TCompareStatus> status1 = AdhocScriptStatus<TCompareStatus>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		AdhocScriptStatus<TCompareStatus> status2 = AdhocScriptStatus<TCompareStatus>();
 		int64_t iteration = 0;
 		TTuple params;
@@ -832,6 +881,7 @@ public:
 	AdhocScriptStatus<AdhocSubstatus<TCompareStatus>> DynamicCompareAdhoc(const TTupleContainer& paramsList, F&& adhocScript, G&& mutator, H&& comparator, I terminator)
 	{
 		AdhocScriptStatus<TCompareStatus> status1 = AdhocScriptStatus<TCompareStatus>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		int64_t iteration = 0;
 		int64_t nMutations = 0;
 		int64_t incumbentMutations = 0;
@@ -898,6 +948,7 @@ public:
 	AdhocScriptStatus<AdhocSubstatus<TCompareStatus>> DynamicCompareAdhoc(F&& paramsGenerator, G&& adhocScript, H&& mutator, I&& comparator, J terminator)
 	{
 		AdhocScriptStatus<TCompareStatus> status1 = AdhocScriptStatus<TCompareStatus>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		int64_t iteration = 0;
 		int64_t nMutations = 0;
 		int64_t incumbentMutations = 0;
@@ -958,6 +1009,7 @@ public:
 	AdhocScriptStatus<AdhocSubstatus<TCompareStatus>> DynamicModifyCompareAdhoc(const TTupleContainer& paramsList, F&& adhocScript, G&& mutator, H&& comparator, I terminator)
 	{
 		AdhocScriptStatus<TCompareStatus> status1 = AdhocScriptStatus<TCompareStatus>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		AdhocScriptStatus<TCompareStatus> status2 = AdhocScriptStatus<TCompareStatus>();
 		int64_t iteration = 0;
 		int64_t nMutations = 0;
@@ -1057,6 +1109,7 @@ public:
 	AdhocScriptStatus<AdhocSubstatus<TCompareStatus>> DynamicModifyCompareAdhoc(F&& paramsGenerator, G&& adhocScript, H&& mutator, I&& comparator, J terminator)
 	{
 		AdhocScriptStatus<TCompareStatus> status1 = AdhocScriptStatus<TCompareStatus>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
 		AdhocScriptStatus<TCompareStatus> status2 = AdhocScriptStatus<TCompareStatus>();
 		int64_t iteration = 0;
 		int64_t nMutations = 0;
@@ -1145,7 +1198,686 @@ public:
 		return AdhocScriptStatus<AdhocSubstatus<TCompareStatus>>(baseStatus, AdhocSubstatus<TCompareStatus>(incumbentMutations, status1));
 	}
 
+	template <class TCompareStatus,
+		class TDiffContainer,
+		AdhocCompareScript<TCompareStatus, std::tuple<>> F,
+		AdhocScriptComparator<TCompareStatus> G,
+		AdhocScriptTerminator<TCompareStatus> H>
+		requires (std::derived_from<typename TDiffContainer::value_type, M64Base>)
+	AdhocScriptStatus<TCompareStatus> CompareDiffsAdhoc(const TDiffContainer& diffs, F&& evaluator, G&& comparator, H terminator)
+	{
+		AdhocScriptStatus<TCompareStatus> status1 = AdhocScriptStatus<TCompareStatus>();
+		IncumbentScope incumbentScope = IncumbentScope(this, status1);
+
+		script->ExecuteAdhoc([&]()
+			{
+				EvaluateDiffsPrefixShared(diffs, evaluator, comparator, terminator, status1);
+				return true;
+			});
+
+		return status1;
+	}
+
+	template <class TCompareStatus,
+		class TDiffContainer,
+		AdhocCompareScript<TCompareStatus, std::tuple<>> F,
+		AdhocScriptComparator<TCompareStatus> G,
+		AdhocScriptTerminator<TCompareStatus> H>
+		requires (std::derived_from<typename TDiffContainer::value_type, M64Base>)
+	AdhocScriptStatus<TCompareStatus> ModifyCompareDiffsAdhoc(const TDiffContainer& diffs, F&& evaluator, G&& comparator, H terminator)
+	{
+		AdhocScriptStatus<TCompareStatus> status1 = CompareDiffsAdhoc<TCompareStatus>(
+			diffs, std::forward<F>(evaluator), std::forward<G>(comparator), terminator);
+
+		// Candidates are evaluated out of order, so the best one always has to be applied afterwards
+		if (status1.executed)
+			script->Apply(status1.m64Diff);
+
+		return status1;
+	}
+
+	template <class TScript,
+		class TStateTracker,
+		class TTupleContainer,
+		typename TTuple = typename TTupleContainer::value_type,
+		ScriptComparator<TScript> F,
+		ScriptTerminator<TScript> G>
+		requires (derived_from_specialization_of<TScript, Script> && constructible_from_tuple<TScript, TTuple>)
+	ScriptStatus<TScript> ParallelCompare(ResourcePool<TResource>& resourcePool, const TTupleContainer& paramsList, F&& comparator, G terminator)
+	{
+		std::vector<ScriptStatus<TScript>> statuses = ExecuteParallel<TScript, TStateTracker>(
+			resourcePool, std::vector<TTuple>(paramsList.begin(), paramsList.end()));
+
+		return ReduceStatuses(statuses, comparator, terminator);
+	}
+
+	template <class TScript,
+		class TStateTracker,
+		typename TTuple,
+		ScriptParamsGenerator<TTuple> F,
+		ScriptComparator<TScript> G,
+		ScriptTerminator<TScript> H>
+		requires (derived_from_specialization_of<TScript, Script> && constructible_from_tuple<TScript, TTuple>)
+	ScriptStatus<TScript> ParallelCompare(ResourcePool<TResource>& resourcePool, F&& paramsGenerator, G&& comparator, H terminator)
+	{
+		std::vector<ScriptStatus<TScript>> statuses = ExecuteParallel<TScript, TStateTracker>(
+			resourcePool, GenerateAllParams<TTuple>(std::forward<F>(paramsGenerator)));
+
+		return ReduceStatuses(statuses, comparator, terminator);
+	}
+
+	template <class TScript,
+		class TStateTracker,
+		class TTupleContainer,
+		typename TTuple = typename TTupleContainer::value_type,
+		ScriptComparator<TScript> F,
+		ScriptTerminator<TScript> G>
+		requires (derived_from_specialization_of<TScript, Script> && constructible_from_tuple<TScript, TTuple>)
+	ScriptStatus<TScript> ParallelModifyCompare(ResourcePool<TResource>& resourcePool, const TTupleContainer& paramsList, F&& comparator, G terminator)
+	{
+		ScriptStatus<TScript> status1 = ParallelCompare<TScript, TStateTracker>(
+			resourcePool, paramsList, std::forward<F>(comparator), terminator);
+
+		if (status1.asserted)
+			script->Apply(status1.m64Diff);
+
+		return status1;
+	}
+
+	template <class TScript,
+		class TStateTracker,
+		typename TTuple,
+		ScriptParamsGenerator<TTuple> F,
+		ScriptComparator<TScript> G,
+		ScriptTerminator<TScript> H>
+		requires (derived_from_specialization_of<TScript, Script> && constructible_from_tuple<TScript, TTuple>)
+	ScriptStatus<TScript> ParallelModifyCompare(ResourcePool<TResource>& resourcePool, F&& paramsGenerator, G&& comparator, H terminator)
+	{
+		ScriptStatus<TScript> status1 = ParallelCompare<TScript, TStateTracker, TTuple>(
+			resourcePool, std::forward<F>(paramsGenerator), std::forward<G>(comparator), terminator);
+
+		if (status1.asserted)
+			script->Apply(status1.m64Diff);
+
+		return status1;
+	}
+
+	// Keep the best k asserted statuses with their diffs, in a heap with the worst one on top. Returned best first.
+	template <class TScript,
+		class TTupleContainer,
+		typename TTuple = typename TTupleContainer::value_type,
+		ScriptComparator<TScript> F>
+		requires (derived_from_specialization_of<TScript, Script> && constructible_from_tuple<TScript, TTuple>)
+	std::vector<ScriptStatus<TScript>> CompareTopK(const TTupleContainer& paramsList, int64_t k, F&& comparator)
+	{
+		std::vector<ScriptStatus<TScript>> topK;
+		for (const auto& params : paramsList)
+			PushTopK(topK, k, ExecuteFromTuple<TScript>(params), comparator);
+
+		return SortTopK(std::move(topK), comparator);
+	}
+
+	template <class TScript,
+		typename TTuple,
+		ScriptParamsGenerator<TTuple> F,
+		ScriptComparator<TScript> G>
+		requires (derived_from_specialization_of<TScript, Script> && constructible_from_tuple<TScript, TTuple>)
+	std::vector<ScriptStatus<TScript>> CompareTopK(F&& paramsGenerator, int64_t k, G&& comparator)
+	{
+		std::vector<ScriptStatus<TScript>> topK;
+		TTuple params;
+		for (int64_t iteration = 0; GenerateParams(std::forward<F>(paramsGenerator), iteration, params); iteration++)
+			PushTopK(topK, k, ExecuteFromTuple<TScript>(params), comparator);
+
+		return SortTopK(std::move(topK), comparator);
+	}
+
+	// Beam search over nLevels levels. The first level runs every set of params from the current state, and each later level
+	// runs every set of params from the end of each of the previous level's k best. Statuses carry the diff of the whole sequence.
+	// Stops early if a level has no successful candidates, returning the previous level's beam, best first.
+	template <class TScript,
+		class TTupleContainer,
+		typename TTuple = typename TTupleContainer::value_type,
+		ScriptComparator<TScript> F>
+		requires (derived_from_specialization_of<TScript, Script> && constructible_from_tuple<TScript, TTuple>)
+	std::vector<ScriptStatus<TScript>> CompareBeam(const TTupleContainer& paramsList, int64_t k, int64_t nLevels, F&& comparator)
+	{
+		std::vector<ScriptStatus<TScript>> beam;
+		for (int64_t level = 0; level < nLevels; level++)
+		{
+			std::vector<ScriptStatus<TScript>> nextBeam;
+			auto expand = [&](const M64Diff* prefix)
+			{
+				script->ExecuteAdhoc([&]()
+					{
+						if (prefix)
+							script->Apply(*prefix);
+
+						for (const auto& params : paramsList)
+						{
+							ScriptStatus<TScript> status = ExecuteFromTuple<TScript>(params);
+							if (prefix)
+								status.m64Diff = MergeDiffs(status.m64Diff, *prefix);
+
+							PushTopK(nextBeam, k, std::move(status), comparator);
+						}
+
+						return true;
+					});
+			};
+
+			if (level == 0)
+				expand(nullptr);
+			else
+			{
+				for (const auto& survivor : beam)
+					expand(&survivor.m64Diff);
+			}
+
+			if (nextBeam.empty())
+				break;
+
+			beam = SortTopK(std::move(nextBeam), comparator);
+		}
+
+		return beam;
+	}
+
+	template <class TScript,
+		class TTupleContainer,
+		typename TTuple = typename TTupleContainer::value_type,
+		ScriptComparator<TScript> F>
+		requires (derived_from_specialization_of<TScript, Script> && constructible_from_tuple<TScript, TTuple>)
+	std::vector<ScriptStatus<TScript>> ModifyCompareBeam(const TTupleContainer& paramsList, int64_t k, int64_t nLevels, F&& comparator)
+	{
+		std::vector<ScriptStatus<TScript>> beam = CompareBeam<TScript>(paramsList, k, nLevels, std::forward<F>(comparator));
+		if (!beam.empty())
+			script->Apply(beam.front().m64Diff);
+
+		return beam;
+	}
+
+	// Evaluate lo, lo + steps[0], ... up to hi, then each finer step within one coarser step of the best point so far
+	template <class TCompareStatus,
+		AdhocCompareScript<TCompareStatus, std::tuple<int64_t>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> GridSearchAdhoc(int64_t lo, int64_t hi, const std::vector<int64_t>& steps, F&& evaluator, G&& comparator)
+	{
+		for (int64_t step : steps)
+			ValidateSearchRange(lo, hi, step);
+
+		return Search<TCompareStatus>(evaluator, comparator, [&](SearchMemo<TCompareStatus>& memo)
+			{
+				for (size_t level = 0; level < steps.size(); level++)
+				{
+					if (level == 0)
+					{
+						for (int64_t param = lo; param <= hi; param += steps[level])
+							EvaluateParam(memo, param, evaluator, comparator);
+
+						continue;
+					}
+
+					if (!memo.best.executed)
+						return;
+
+					int64_t center = memo.bestParam;
+					for (int64_t param = center - steps[level]; param > center - steps[level - 1] && param >= lo; param -= steps[level])
+						EvaluateParam(memo, param, evaluator, comparator);
+
+					for (int64_t param = center + steps[level]; param < center + steps[level - 1] && param <= hi; param += steps[level])
+						EvaluateParam(memo, param, evaluator, comparator);
+				}
+			});
+	}
+
+	// Golden-section search over lo, lo + step, ... up to hi. Only finds the optimum if the metric is unimodal over the range.
+	template <class TCompareStatus,
+		AdhocCompareScript<TCompareStatus, std::tuple<int64_t>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> GoldenSectionSearchAdhoc(int64_t lo, int64_t hi, int64_t step, F&& evaluator, G&& comparator)
+	{
+		ValidateSearchRange(lo, hi, step);
+
+		return Search<TCompareStatus>(evaluator, comparator, [&](SearchMemo<TCompareStatus>& memo)
+			{
+				GoldenSectionSearchInternal(memo, lo, hi, step, evaluator, comparator);
+			});
+	}
+
+	// Walk away from start in whichever direction improves, doubling the stride each time, until the metric gets worse.
+	// The optimum is then bracketed and is refined with golden-section search on multiples of step.
+	template <class TCompareStatus,
+		AdhocCompareScript<TCompareStatus, std::tuple<int64_t>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> BracketSearchAdhoc(int64_t start, int64_t step, int64_t lo, int64_t hi, F&& evaluator, G&& comparator)
+	{
+		ValidateSearchRange(lo, hi, step);
+
+		return Search<TCompareStatus>(evaluator, comparator, [&](SearchMemo<TCompareStatus>& memo)
+			{
+				start = std::clamp(start, lo, hi);
+				const auto& startStatus = EvaluateParam(memo, start, evaluator, comparator);
+
+				int64_t direction = 1;
+				if (start + step > hi || !IsBetter(comparator, startStatus, EvaluateParam(memo, start + step, evaluator, comparator)))
+				{
+					direction = -1;
+					if (start - step < lo || !IsBetter(comparator, startStatus, EvaluateParam(memo, start - step, evaluator, comparator)))
+						return;
+				}
+
+				int64_t previous = start;
+				int64_t current = start + direction * step;
+				int64_t next = current;
+				for (int64_t stride = 2 * step; ; stride *= 2)
+				{
+					next = std::clamp(current + direction * stride, lo, hi);
+					if (next == current)
+						break;
+
+					if (!IsBetter(comparator, EvaluateParam(memo, current, evaluator, comparator), EvaluateParam(memo, next, evaluator, comparator)))
+						break;
+
+					previous = current;
+					current = next;
+				}
+
+				GoldenSectionSearchInternal(memo, std::min(previous, next), std::max(previous, next), step, evaluator, comparator);
+			});
+	}
+
+	// Same as the searches above, but the best status is applied afterwards
+	template <class TCompareStatus,
+		AdhocCompareScript<TCompareStatus, std::tuple<int64_t>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> ModifyGridSearchAdhoc(int64_t lo, int64_t hi, const std::vector<int64_t>& steps, F&& evaluator, G&& comparator)
+	{
+		return ApplySearchResult(GridSearchAdhoc<TCompareStatus>(lo, hi, steps, std::forward<F>(evaluator), std::forward<G>(comparator)));
+	}
+
+	template <class TCompareStatus,
+		AdhocCompareScript<TCompareStatus, std::tuple<int64_t>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> ModifyGoldenSectionSearchAdhoc(int64_t lo, int64_t hi, int64_t step, F&& evaluator, G&& comparator)
+	{
+		return ApplySearchResult(GoldenSectionSearchAdhoc<TCompareStatus>(lo, hi, step, std::forward<F>(evaluator), std::forward<G>(comparator)));
+	}
+
+	template <class TCompareStatus,
+		AdhocCompareScript<TCompareStatus, std::tuple<int64_t>> F,
+		AdhocScriptComparator<TCompareStatus> G>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> ModifyBracketSearchAdhoc(int64_t start, int64_t step, int64_t lo, int64_t hi, F&& evaluator, G&& comparator)
+	{
+		return ApplySearchResult(BracketSearchAdhoc<TCompareStatus>(start, step, lo, hi, std::forward<F>(evaluator), std::forward<G>(comparator)));
+	}
+
 private:
+	const void* incumbent = nullptr;
+	const std::type_info* incumbentType = nullptr;
+
+	// Publishes a compare's incumbent status to its candidates while the compare runs. Restores the enclosing compare's incumbent afterwards.
+	class IncumbentScope
+	{
+	public:
+		template <class TStatus>
+		IncumbentScope(ScriptCompareHelper<TResource>* helper, const TStatus& status)
+			: helper(helper), previousIncumbent(helper->incumbent), previousIncumbentType(helper->incumbentType)
+		{
+			helper->incumbent = &status;
+			helper->incumbentType = &typeid(TStatus);
+		}
+
+		IncumbentScope(const IncumbentScope&) = delete;
+		IncumbentScope& operator= (const IncumbentScope&) = delete;
+
+		~IncumbentScope()
+		{
+			helper->incumbent = previousIncumbent;
+			helper->incumbentType = previousIncumbentType;
+		}
+
+	private:
+		ScriptCompareHelper<TResource>* helper;
+		const void* previousIncumbent;
+		const std::type_info* previousIncumbentType;
+	};
+
+	// Run each candidate on a pool resource brought to the current state. Defined in Script.t.hpp, since it needs TopLevelScript.
+	template <class TScript, class TStateTracker, typename TTuple>
+	std::vector<ScriptStatus<TScript>> ExecuteParallel(ResourcePool<TResource>& resourcePool, const std::vector<TTuple>& paramsList);
+
+	// Shares the top-level script's state tracker factory with workers. Throws if TStateTracker doesn't match.
+	template <class TStateTracker>
+	auto GetStateTrackerFactory();
+
+	// Select from statuses in candidate order, the same way the serial loop does, so the result doesn't depend on scheduling
+	template <class TScript, typename F, typename G>
+	ScriptStatus<TScript> ReduceStatuses(std::vector<ScriptStatus<TScript>>& statuses, F& comparator, G& terminator)
+	{
+		if (statuses.empty())
+			return ScriptStatus<TScript>();
+
+		ScriptStatus<TScript> status1 = statuses[0];
+		if (status1.asserted && script->ExecuteAdhoc([&]() { return terminator(&status1); }).executed)
+			return status1;
+
+		for (size_t i = 1; i < statuses.size(); i++)
+		{
+			if (statuses[i].asserted && script->ExecuteAdhoc([&]() { return terminator(&statuses[i]); }).executed)
+				return statuses[i];
+
+			SelectStatus(comparator, status1, statuses[i]);
+		}
+
+		return status1;
+	}
+
+	// Heap ordering for top-k and beam compares. The worst kept status is on top, so it is the one replaced.
+	template <class TScript, typename F>
+	void PushTopK(std::vector<ScriptStatus<TScript>>& topK, int64_t k, ScriptStatus<TScript>&& status, F& comparator)
+	{
+		if (!status.asserted || k <= 0)
+			return;
+
+		auto isBetter = [&](const ScriptStatus<TScript>& status1, const ScriptStatus<TScript>& status2) { return IsBetter(comparator, status2, status1); };
+		if (static_cast<int64_t>(topK.size()) < k)
+		{
+			topK.push_back(std::move(status));
+			std::push_heap(topK.begin(), topK.end(), isBetter);
+			return;
+		}
+
+		if (!IsBetter(comparator, topK.front(), status))
+			return;
+
+		std::pop_heap(topK.begin(), topK.end(), isBetter);
+		topK.back() = std::move(status);
+		std::push_heap(topK.begin(), topK.end(), isBetter);
+	}
+
+	template <class TScript, typename F>
+	std::vector<ScriptStatus<TScript>> SortTopK(std::vector<ScriptStatus<TScript>>&& topK, F& comparator)
+	{
+		std::sort_heap(topK.begin(), topK.end(),
+			[&](const ScriptStatus<TScript>& status1, const ScriptStatus<TScript>& status2) { return IsBetter(comparator, status2, status1); });
+
+		return std::move(topK);
+	}
+
+	// Statuses evaluated so far by a one-dimensional search, by parameter
+	template <class TCompareStatus>
+	class SearchMemo
+	{
+	public:
+		std::map<int64_t, AdhocScriptStatus<TCompareStatus>> statuses;
+		AdhocScriptStatus<TCompareStatus> best;
+		int64_t bestParam = 0;
+	};
+
+	template <class TCompareStatus, typename F, typename G, typename H>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> Search(F& evaluator, G& comparator, H search)
+	{
+		SearchMemo<TCompareStatus> memo;
+		IncumbentScope incumbentScope = IncumbentScope(this, memo.best);
+		bool monotonic = true;
+
+		auto baseStatus = script->ExecuteAdhoc([&]()
+			{
+				search(memo);
+				monotonic = IsMonotonic(memo, comparator);
+				return memo.best.executed;
+			});
+
+		return AdhocScriptStatus<SearchSubstatus<TCompareStatus>>(baseStatus,
+			SearchSubstatus<TCompareStatus>(memo.statuses.size(), memo.bestParam, monotonic, memo.best));
+	}
+
+	template <class TCompareStatus>
+	AdhocScriptStatus<SearchSubstatus<TCompareStatus>> ApplySearchResult(AdhocScriptStatus<SearchSubstatus<TCompareStatus>> status)
+	{
+		if (status.executed)
+			script->Apply(status.substatus.m64Diff);
+
+		return status;
+	}
+
+	template <class TCompareStatus, typename F, typename G>
+	const AdhocScriptStatus<TCompareStatus>& EvaluateParam(SearchMemo<TCompareStatus>& memo, int64_t param, F& evaluator, G& comparator)
+	{
+		auto evaluated = memo.statuses.find(param);
+		if (evaluated != memo.statuses.end())
+			return evaluated->second;
+
+		std::tuple<int64_t> params = std::tuple<int64_t>(param);
+		const auto& status = memo.statuses[param] = ExecuteFromTupleAdhoc<TCompareStatus>(evaluator, params);
+
+		if (memo.statuses.size() == 1 || IsBetter(comparator, memo.best, status))
+		{
+			memo.best = status;
+			memo.bestParam = param;
+		}
+
+		return status;
+	}
+
+	// Steps that aren't positive would never reach hi
+	static void ValidateSearchRange(int64_t lo, int64_t hi, int64_t step)
+	{
+		if (step <= 0)
+			throw std::invalid_argument("Search step must be positive");
+
+		if (lo > hi)
+			throw std::invalid_argument("Search range is empty");
+	}
+
+	template <class TCompareStatus, typename F, typename G>
+	void GoldenSectionSearchInternal(SearchMemo<TCompareStatus>& memo, int64_t lo, int64_t hi, int64_t step, F& evaluator, G& comparator)
+	{
+		// Search grid indices, so interior points stay on the grid and each iteration reuses one of them
+		auto evaluate = [&](int64_t index) -> const AdhocScriptStatus<TCompareStatus>& { return EvaluateParam(memo, lo + index * step, evaluator, comparator); };
+
+		int64_t left = 0;
+		int64_t right = (hi - lo) / step;
+		int64_t inner1 = left + std::llround((right - left) * 0.381966011250105);
+		int64_t inner2 = left + right - inner1;
+
+		while (left < inner1 && inner1 < inner2 && inner2 < right)
+		{
+			if (IsBetter(comparator, evaluate(inner1), evaluate(inner2)))
+			{
+				left = inner1;
+				inner1 = inner2;
+				inner2 = left + right - inner1;
+			}
+			else
+			{
+				right = inner2;
+				inner2 = inner1;
+				inner1 = left + right - inner2;
+			}
+
+			if (inner1 > inner2)
+				std::swap(inner1, inner2);
+		}
+
+		// Too few points left to split, so check them all
+		for (int64_t index = left; index <= right; index++)
+			evaluate(index);
+	}
+
+	template <class TCompareStatus, typename G>
+	bool IsMonotonic(SearchMemo<TCompareStatus>& memo, G& comparator)
+	{
+		auto best = memo.statuses.find(memo.bestParam);
+		if (best == memo.statuses.end())
+			return true;
+
+		for (auto status = best; status != memo.statuses.begin(); status--)
+		{
+			if (IsBetter(comparator, status->second, std::prev(status)->second))
+				return false;
+		}
+
+		for (auto status = best; std::next(status) != memo.statuses.end(); status++)
+		{
+			if (IsBetter(comparator, status->second, std::next(status)->second))
+				return false;
+		}
+
+		return true;
+	}
+
+	// Whether status2 would replace status1 as the incumbent, without modifying either
+	template <class TStatus, typename G>
+	bool IsBetter(G& comparator, const TStatus& status1, const TStatus& status2)
+	{
+		if (!status2.executed)
+			return false;
+
+		if (!status1.executed)
+			return true;
+
+		bool better = false;
+		script->ExecuteAdhoc([&]()
+			{
+				better = comparator(&status1, &status2) == &status2;
+				return true;
+			});
+
+		return better;
+	}
+
+	template <typename TTuple, ScriptParamsGenerator<TTuple> F>
+	std::vector<TTuple> GenerateAllParams(F&& paramsGenerator)
+	{
+		std::vector<TTuple> paramsList;
+		TTuple params;
+		for (int64_t iteration = 0; GenerateParams(std::forward<F>(paramsGenerator), iteration, params); iteration++)
+			paramsList.push_back(params);
+
+		return paramsList;
+	}
+
+	// Evaluate each diff as if it had been applied to the current state, advancing shared input prefixes only once.
+	// Candidates are arranged in a trie, with saves made at branch points so sibling subtrees can resume from there.
+	// Results are compared in container order as soon as every earlier candidate is evaluated, so ties and termination
+	// match evaluating the diffs one by one, and the terminator stops the traversal early.
+	template <class TCompareStatus, class TDiffContainer, typename F, typename G, typename H>
+	bool EvaluateDiffsPrefixShared(const TDiffContainer& diffs, F& evaluator, G& comparator, H& terminator, AdhocScriptStatus<TCompareStatus>& status1)
+	{
+		std::vector<AdhocScriptStatus<TCompareStatus>> results(std::size(diffs));
+		std::vector<bool> evaluated(std::size(diffs), false);
+		size_t nextResult = 0;
+		bool terminated = false;
+		auto evaluate = [&](const M64Base& diff, size_t index)
+		{
+			TCompareStatus compareStatus = TCompareStatus();
+			auto baseStatus = script->ExecuteAdhoc([&]() { return evaluator(&compareStatus); });
+
+			// Inputs the evaluator wrote itself take precedence over the candidate's
+			AdhocScriptStatus<TCompareStatus>& status2 = results[index];
+			status2 = AdhocScriptStatus<TCompareStatus>(baseStatus, compareStatus);
+			status2.m64Diff.frames.insert(diff.frames.begin(), diff.frames.end());
+			evaluated[index] = true;
+
+			for (; !terminated && nextResult < results.size() && evaluated[nextResult]; nextResult++)
+			{
+				AdhocScriptStatus<TCompareStatus>& nextStatus = results[nextResult];
+				if (nextStatus.executed && script->ExecuteAdhoc([&]() { return terminator(&nextStatus); }).executed)
+				{
+					status1 = nextStatus;
+					terminated = true;
+				}
+				else
+					SelectStatusAdhoc(comparator, status1, nextStatus);
+			}
+		};
+
+		// Empty diffs are evaluated on the current frame, same as applying them would
+		int64_t startFrame = -1;
+		size_t index = 0;
+		for (const auto& diff : diffs)
+		{
+			if (diff.frames.empty())
+				evaluate(diff, index);
+			else if (startFrame == -1 || static_cast<int64_t>(diff.frames.begin()->first) < startFrame)
+				startFrame = diff.frames.begin()->first;
+
+			if (terminated)
+				return true;
+
+			index++;
+		}
+
+		// Fill gaps in each diff with the inputs it would be applied on top of
+		std::vector<std::pair<const M64Base*, size_t>> candidates;
+		InputTrie trie = InputTrie(startFrame);
+		index = 0;
+		for (const auto& diff : diffs)
+		{
+			if (!diff.frames.empty())
+			{
+				std::vector<Inputs> inputs;
+				int64_t lastFrame = diff.frames.rbegin()->first;
+				inputs.reserve(lastFrame - startFrame + 1);
+				for (int64_t frame = startFrame; frame <= lastFrame; frame++)
+					inputs.push_back(diff.frames.contains(frame) ? diff.frames.at(frame) : script->GetInputs(frame));
+
+				trie.Insert(candidates.size(), inputs);
+				candidates.emplace_back(&diff, index);
+			}
+
+			index++;
+		}
+
+		// Depth-first traversal. Each stack entry is a node and the index of the next child to visit.
+		if (!candidates.empty())
+		{
+			script->Load(startFrame);
+			std::vector<std::pair<int64_t, size_t>> stack;
+			stack.emplace_back(0, 0);
+			while (!stack.empty() && !terminated)
+			{
+				auto& [node, nextChild] = stack.back();
+
+				// First visit to this node
+				if (nextChild == 0)
+				{
+					if (trie.IsBranchPoint(node))
+						script->Save();
+
+					for (int64_t candidate : trie.nodes[node].candidates)
+					{
+						evaluate(*candidates[candidate].first, candidates[candidate].second);
+						if (terminated)
+							break;
+					}
+
+					if (terminated)
+						break;
+				}
+
+				if (nextChild == trie.nodes[node].children.size())
+				{
+					stack.pop_back();
+					continue;
+				}
+
+				// Return to branch point before descending into a sibling subtree
+				if (nextChild > 0)
+					script->Rollback(trie.nodes[node].frame);
+
+				int64_t child = trie.nodes[node].children[nextChild++];
+				script->AdvanceFrameWrite(trie.nodes[child].inputs);
+				stack.emplace_back(child, 0);
+			}
+		}
+
+		return terminated;
+	}
+
+
 	M64Diff MergeDiffs(const M64Diff& diff1, const M64Diff& diff2)
 	{
 		M64Diff newDiff;
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <vector>
+
+#ifndef SCRIPT_PROFILER_H
+#define SCRIPT_PROFILER_H
+
+/// <summary>
+/// Attributes time, frame advances, saves and loads to each script type and adhoc call site, nested by call stack.
+/// Disabled by default. When disabled, entering a script costs a single atomic load.
+/// Each thread records into its own call tree without locking. Trees are merged by name when written out,
+/// so Reset and the Write methods must only be called while no profiled scripts are running on other threads.
+/// </summary>
+class ScriptProfiler
+{
+public:
+	/// <summary>
+	/// Enters on construction and exits on destruction, so the stack stays balanced when a script throws.
+	/// The counts are read on exit and should be the script's inclusive totals.
+	/// </summary>
+	class Scope
+	{
+	public:
+		Scope(const std::type_info& type, bool isAdhoc, const uint64_t& nFrameAdvances, const uint64_t& nSaves, const uint64_t& nLoads)
+			: entered(Enter(type, isAdhoc)), nFrameAdvances(nFrameAdvances), nSaves(nSaves), nLoads(nLoads) {}
+
+		Scope(const Scope&) = delete;
+		Scope& operator= (const Scope&) = delete;
+
+		~Scope()
+		{
+			Exit(entered, nFrameAdvances, nSaves, nLoads);
+		}
+
+	private:
+		bool entered;
+		const uint64_t& nFrameAdvances;
+		const uint64_t& nSaves;
+		const uint64_t& nLoads;
+	};
+
+	static void Enable();
+	static void Disable();
+	static bool IsEnabled();
+
+	// Clear recorded data on all threads
+	static void Reset();
+
+	// Push a script (isAdhoc = false) or an adhoc lambda (isAdhoc = true) onto this thread's stack.
+	// Returns whether anything was pushed, which must be passed on to the matching Exit call. Prefer Scope.
+	static bool Enter(const std::type_info& type, bool isAdhoc);
+
+	// Pop the current script, given its inclusive counts
+	static void Exit(bool entered, uint64_t nFrameAdvances, uint64_t nSaves, uint64_t nLoads);
+
+	// One line per call stack with its exclusive time in nanoseconds, e.g. for flamegraph.pl or speedscope
+	static void WriteFoldedStacks(std::ostream& stream);
+
+	// Exclusive and inclusive totals per script type and adhoc call site
+	static void WriteJsonSummary(std::ostream& stream);
+
+private:
+	class Node
+	{
+	public:
+		std::type_index type = typeid(void);
+		bool isAdhoc = false;
+		std::vector<int64_t> children;
+		uint64_t nCalls = 0;
+		uint64_t duration = 0;
+		uint64_t nFrameAdvances = 0;
+		uint64_t nSaves = 0;
+		uint64_t nLoads = 0;
+
+		Node() = default;
+		Node(std::type_index type, bool isAdhoc) : type(type), isAdhoc(isAdhoc) {}
+	};
+
+	class StackFrame
+	{
+	public:
+		int64_t node = 0;
+		uint64_t startTime = 0;
+	};
+
+	class ThreadProfile
+	{
+	public:
+		std::vector<Node> nodes = std::vector<Node>(1); // nodes[0] is the root
+		std::vector<StackFrame> stack;
+	};
+
+	class MergedNode;
+
+	static std::atomic<bool> enabled;
+	static std::mutex threadProfilesMutex; // Guards the list of threads, not their profiles
+	static std::vector<std::shared_ptr<ThreadProfile>> threadProfiles;
+
+	static ThreadProfile& GetThreadProfile();
+	static uint64_t GetTime();
+	static std::string GetName(const Node& node);
+	static MergedNode Merge();
+};
+
+#endif
@@ -20,6 +20,8 @@ public:
 	bool validated = false;
 	bool executed = false;
 	bool asserted = false;
+	bool aborted = false; // Gave up early because it could not beat the incumbent of the compare it was a candidate in
+	bool budgetExceeded = false; // Failed because it ran out of frame advances, loads or time
 	uint64_t validationDuration = 0;
 	uint64_t executionDuration = 0;
 	uint64_t assertionDuration = 0;
@@ -30,6 +32,10 @@ public:
 	uint64_t nLoads = 0;
 	uint64_t nSaves = 0;
 	uint64_t nFrameAdvances = 0;
+	uint64_t nAborts = 0; // Aborted candidates, including this script and anything it ran
+	uint64_t trackedStateMemory = 0; // Approximate bytes held by tracked states at the end of a top-level script
+	uint64_t peakTrackedStateMemory = 0;
+	uint64_t nEvictedTrackedStates = 0;
 	M64Diff m64Diff = M64Diff();
 
 	BaseScriptStatus() = default;
@@ -49,6 +55,8 @@ class AdhocBaseScriptStatus
 {
 public:
 	bool executed = false;
+	bool aborted = false;
+	bool budgetExceeded = false;
 	uint64_t totalDuration = 0;
 	uint64_t saveDuration = 0;
 	uint64_t loadDuration = 0;
@@ -56,6 +64,7 @@ public:
 	uint64_t nLoads = 0;
 	uint64_t nSaves = 0;
 	uint64_t nFrameAdvances = 0;
+	uint64_t nAborts = 0;
 	M64Diff m64Diff = M64Diff();
 
 	AdhocBaseScriptStatus() = default;
@@ -63,6 +72,9 @@ public:
 	AdhocBaseScriptStatus(BaseScriptStatus baseStatus)
 	{
 		executed = baseStatus.executed;
+		aborted = baseStatus.aborted;
+		budgetExceeded = baseStatus.budgetExceeded;
+		nAborts = baseStatus.nAborts;
 		nLoads = baseStatus.nLoads;
 		nSaves = baseStatus.nSaves;
 		nFrameAdvances = baseStatus.nFrameAdvances;
@@ -0,0 +1,88 @@
+#pragma once
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+#include <type_traits>
+
+#ifndef TRACKED_STATE_BUFFER_H
+#define TRACKED_STATE_BUFFER_H
+
+// States that own heap memory can report it, so that it counts towards the tracked state memory budget
+template <typename TState>
+concept HeapMeasurableState = requires (const TState& state)
+{
+	{ state.GetHeapMemoryUsage() } -> std::convertible_to<uint64_t>;
+};
+
+// States that can be copied byte for byte and own nothing, so buffers can copy them in bulk and skip per-state bookkeeping
+template <typename TState>
+concept BitwiseCopyableState = std::is_trivially_copyable_v<TState> && std::is_trivially_destructible_v<TState> && !HeapMeasurableState<TState>;
+
+/// <summary>
+/// Memory budget for the tracked states of a TopLevelScript. Every tracked state can be recomputed with the state tracker,
+/// so once the budget is exceeded, older states are evicted and recomputed on demand.
+/// </summary>
+class TrackedStateBudget
+{
+public:
+	uint64_t maxMemory = 0; // In bytes. 0 means unlimited.
+	int64_t checkpointInterval = 16; // Evicted ranges keep every nth frame, so recomputing a state never has to go back further than this
+	int64_t nRecentFrames = 64; // The most recent frames of each buffer are never evicted
+};
+
+/// <summary>
+/// Tracked states of one script at one ad-hoc level, stored by offset from the earliest tracked frame.
+/// Storage only grows or shrinks at its ends, so references to stored states stay valid until those frames are erased or evicted.
+/// States before the dense range (evicted checkpoints and recomputed states) are kept in a sparse map.
+/// </summary>
+template <typename TState>
+class TrackedStateBuffer
+{
+public:
+	TrackedStateBuffer() = default;
+
+	TrackedStateBuffer(const TrackedStateBuffer<TState>&) = delete;
+	TrackedStateBuffer<TState>& operator= (const TrackedStateBuffer<TState>&) = delete;
+
+	TrackedStateBuffer(TrackedStateBuffer<TState>&&) = default;
+	TrackedStateBuffer<TState>& operator= (TrackedStateBuffer<TState>&&) = default;
+
+	// Returns nullptr if no state is tracked on this frame
+	const TState* Find(int64_t frame) const;
+
+	const TState& Set(int64_t frame, TState&& state);
+
+	// Erase all states at or after firstFrame
+	void Erase(int64_t firstFrame);
+
+	// Transfer states that dest does not already have
+	void MoveInto(TrackedStateBuffer<TState>& dest);
+
+	// Drop all but the most recent and checkpoint frames. Returns the number of states evicted.
+	uint64_t Evict(const TrackedStateBudget& budget);
+
+	// Approximate memory held by this buffer, in bytes
+	uint64_t GetMemoryUsage() const { return memoryUsage; }
+
+private:
+	// Approximate per-node overhead of std::map
+	static constexpr uint64_t sparseNodeOverhead = 4 * sizeof(void*);
+
+	int64_t firstFrame = 0;
+	std::deque<std::optional<TState>> states;
+	std::map<int64_t, TState> sparseStates;
+	uint64_t memoryUsage = 0;
+
+	static uint64_t GetHeapMemoryUsage(const TState& state);
+	void EraseSparse(typename std::map<int64_t, TState>::iterator sparseState);
+	void PopFront();
+	void PopBack();
+};
+
+//Include template method implementations
+#include "tasfw/TrackedStateBuffer.t.hpp"
+
+#endif
@@ -0,0 +1,195 @@
+#pragma once
+#ifndef TRACKED_STATE_BUFFER_H
+#error "TrackedStateBuffer.t.hpp should only be included by TrackedStateBuffer.hpp"
+#else
+
+template <typename TState>
+const TState* TrackedStateBuffer<TState>::Find(int64_t frame) const
+{
+	int64_t offset = frame - firstFrame;
+	if (offset < 0 || offset >= static_cast<int64_t>(states.size()) || !states[offset])
+	{
+		if (sparseStates.empty())
+			return nullptr;
+
+		auto sparseState = sparseStates.find(frame);
+		return sparseState == sparseStates.end() ? nullptr : &sparseState->second;
+	}
+
+	return &*states[offset];
+}
+
+template <typename TState>
+const TState& TrackedStateBuffer<TState>::Set(int64_t frame, TState&& state)
+{
+	uint64_t heapMemoryUsage = GetHeapMemoryUsage(state);
+
+	// Frames before the dense range go in the sparse map, so that recomputing an evicted state doesn't regrow the dense range
+	if ((!states.empty() && frame < firstFrame) || (states.empty() && !sparseStates.empty() && frame <= sparseStates.rbegin()->first))
+	{
+		auto sparseState = sparseStates.find(frame);
+		if (sparseState != sparseStates.end())
+			EraseSparse(sparseState);
+
+		memoryUsage += sizeof(std::pair<const int64_t, TState>) + sparseNodeOverhead + heapMemoryUsage;
+		return sparseStates.emplace(frame, std::move(state)).first->second;
+	}
+
+	if (states.empty())
+		firstFrame = frame;
+
+	int64_t offset = frame - firstFrame;
+	if (offset >= static_cast<int64_t>(states.size()))
+	{
+		memoryUsage += (offset + 1 - states.size()) * sizeof(std::optional<TState>);
+		states.resize(offset + 1);
+	}
+
+	if (states[offset])
+		memoryUsage -= GetHeapMemoryUsage(*states[offset]);
+
+	memoryUsage += heapMemoryUsage;
+	states[offset] = std::move(state);
+	return *states[offset];
+}
+
+template <typename TState>
+void TrackedStateBuffer<TState>::Erase(int64_t firstErasedFrame)
+{
+	auto sparseState = sparseStates.lower_bound(firstErasedFrame);
+	while (sparseState != sparseStates.end())
+		EraseSparse(sparseState++);
+
+	// Common case when writing at the end: nothing to erase
+	int64_t nKeptStates = std::max(firstErasedFrame - firstFrame, int64_t(0));
+	if (nKeptStates >= static_cast<int64_t>(states.size()))
+		return;
+
+	if constexpr (BitwiseCopyableState<TState>)
+	{
+		memoryUsage -= (states.size() - nKeptStates) * sizeof(std::optional<TState>);
+		states.resize(nKeptStates);
+	}
+	else
+	{
+		while (static_cast<int64_t>(states.size()) > nKeptStates)
+			PopBack();
+	}
+}
+
+template <typename TState>
+void TrackedStateBuffer<TState>::MoveInto(TrackedStateBuffer<TState>& dest)
+{
+	for (auto& [frame, state] : sparseStates)
+	{
+		if (!dest.Find(frame))
+			dest.Set(frame, std::move(state));
+	}
+
+	// Common case: the states continue after the end of dest's dense range, so they can be appended in bulk
+	int64_t destEndFrame = dest.firstFrame + static_cast<int64_t>(dest.states.size());
+	if constexpr (BitwiseCopyableState<TState>)
+	{
+		if (!states.empty() && !dest.states.empty() && destEndFrame <= firstFrame)
+		{
+			uint64_t nAddedStates = firstFrame + states.size() - destEndFrame;
+			dest.states.resize(firstFrame - dest.firstFrame);
+			dest.states.insert(dest.states.end(), states.begin(), states.end());
+			dest.memoryUsage += nAddedStates * sizeof(std::optional<TState>);
+			states.clear();
+		}
+	}
+
+	for (int64_t offset = 0; offset < static_cast<int64_t>(states.size()); offset++)
+	{
+		if (states[offset] && !dest.Find(firstFrame + offset))
+			dest.Set(firstFrame + offset, std::move(*states[offset]));
+	}
+
+	states.clear();
+	sparseStates.clear();
+	memoryUsage = 0;
+}
+
+template <typename TState>
+uint64_t TrackedStateBuffer<TState>::Evict(const TrackedStateBudget& budget)
+{
+	auto isCheckpoint = [&](int64_t frame) { return budget.checkpointInterval > 0 && frame % budget.checkpointInterval == 0; };
+	uint64_t nEvicted = 0;
+
+	// Recomputed states outside the dense range are only worth keeping as checkpoints
+	auto sparseState = sparseStates.begin();
+	while (sparseState != sparseStates.end())
+	{
+		if (isCheckpoint(sparseState->first))
+			sparseState++;
+		else
+		{
+			EraseSparse(sparseState++);
+			nEvicted++;
+		}
+	}
+
+	int64_t nEvictedFrames = static_cast<int64_t>(states.size()) - std::max(budget.nRecentFrames, int64_t(0));
+	for (int64_t i = 0; i < nEvictedFrames; i++)
+	{
+		if (states.front())
+		{
+			if (isCheckpoint(firstFrame))
+			{
+				uint64_t heapMemoryUsage = GetHeapMemoryUsage(*states.front());
+				memoryUsage += sizeof(std::pair<const int64_t, TState>) + sparseNodeOverhead + heapMemoryUsage;
+				sparseStates.emplace(firstFrame, std::move(*states.front()));
+
+				// The heap memory moved with the state
+				memoryUsage -= heapMemoryUsage;
+				states.front().reset();
+			}
+			else
+				nEvicted++;
+		}
+
+		PopFront();
+	}
+
+	return nEvicted;
+}
+
+template <typename TState>
+uint64_t TrackedStateBuffer<TState>::GetHeapMemoryUsage(const TState& state)
+{
+	if constexpr (HeapMeasurableState<TState>)
+		return state.GetHeapMemoryUsage();
+	else
+		return 0;
+}
+
+template <typename TState>
+void TrackedStateBuffer<TState>::EraseSparse(typename std::map<int64_t, TState>::iterator sparseState)
+{
+	memoryUsage -= sizeof(std::pair<const int64_t, TState>) + sparseNodeOverhead + GetHeapMemoryUsage(sparseState->second);
+	sparseStates.erase(sparseState);
+}
+
+template <typename TState>
+void TrackedStateBuffer<TState>::PopFront()
+{
+	if (states.front())
+		memoryUsage -= GetHeapMemoryUsage(*states.front());
+
+	memoryUsage -= sizeof(std::optional<TState>);
+	states.pop_front();
+	firstFrame++;
+}
+
+template <typename TState>
+void TrackedStateBuffer<TState>::PopBack()
+{
+	if (states.back())
+		memoryUsage -= GetHeapMemoryUsage(*states.back());
+
+	memoryUsage -= sizeof(std::optional<TState>);
+	states.pop_back();
+}
+
+#endif
@@ -0,0 +1,50 @@
+#include <tasfw/CheckpointSchedule.hpp>
+
+#include <algorithm>
+#include <limits>
+
+int64_t CheckpointSchedule::Beta(int64_t nCheckpoints, int64_t nReplays)
+{
+	constexpr int64_t maxBeta = std::numeric_limits<int64_t>::max() / 2;
+
+	// binomial(s + t, s) built up incrementally as product of (t + i) / i, which stays integral at every step
+	int64_t k = (std::min)(nCheckpoints, nReplays);
+	int64_t n = nCheckpoints + nReplays;
+	int64_t beta = 1;
+	for (int64_t i = 1; i <= k; i++)
+	{
+		if (beta > maxBeta / (n - k + i))
+			return maxBeta;
+
+		beta = beta * (n - k + i) / i;
+	}
+
+	return beta;
+}
+
+std::vector<int64_t> CheckpointSchedule::GetCheckpointFrames(int64_t startFrame, int64_t endFrame, int64_t nFreeCheckpoints)
+{
+	std::vector<int64_t> frames;
+
+	// Snapshot count includes the existing save at the start of each sub-range
+	int64_t nCheckpoints = nFreeCheckpoints + 1;
+	int64_t frame = startFrame;
+	while (nCheckpoints > 1 && endFrame - frame > 1)
+	{
+		int64_t nFrames = endFrame - frame;
+
+		// Minimum number of replays needed to cover the range
+		int64_t nReplays = 1;
+		while (Beta(nCheckpoints, nReplays) < nFrames)
+			nReplays++;
+
+		// Any advance in [nFrames - Beta(s - 1, t), Beta(s, t - 1)] is optimal. Take the largest one.
+		int64_t advance = (std::min)(Beta(nCheckpoints, nReplays - 1), nFrames - 1);
+
+		frame += advance;
+		frames.push_back(frame);
+		nCheckpoints--;
+	}
+
+	return frames;
+}
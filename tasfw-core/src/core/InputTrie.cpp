@@ -0,0 +1,41 @@
+#include <tasfw/InputTrie.hpp>
+
+InputTrie::InputTrie(int64_t startFrame) : startFrame(startFrame)
+{
+	nodes.emplace_back(Inputs(), startFrame);
+}
+
+void InputTrie::Insert(int64_t candidate, const std::vector<Inputs>& inputs)
+{
+	int64_t node = 0;
+	for (const Inputs& frameInputs : inputs)
+	{
+		int64_t next = -1;
+		for (int64_t child : nodes[node].children)
+		{
+			if (nodes[child].inputs == frameInputs)
+			{
+				next = child;
+				break;
+			}
+		}
+
+		if (next == -1)
+		{
+			next = nodes.size();
+			int64_t frame = nodes[node].frame + 1;
+			nodes.emplace_back(frameInputs, frame);
+			nodes[node].children.push_back(next);
+		}
+
+		node = next;
+	}
+
+	nodes[node].candidates.push_back(candidate);
+}
+
+bool InputTrie::IsBranchPoint(int64_t node) const
+{
+	// Evaluating a candidate reverts to this node, as does moving to a sibling subtree
+	return nodes[node].children.size() > 1 || (!nodes[node].children.empty() && !nodes[node].candidates.empty());
+}
@@ -0,0 +1,54 @@
+#include <tasfw/ScriptBudget.hpp>
+
+#include <chrono>
+
+bool ScriptBudget::IsUnlimited() const
+{
+	return maxFrameAdvances == 0 && maxLoads == 0 && maxDuration == 0;
+}
+
+ScriptBudgetScope::ScriptBudgetScope(const ScriptBudget& budget, ScriptBudgetScope* parent)
+	: _budget(budget), _parent(parent), _startTime(GetTime()) {}
+
+void ScriptBudgetScope::Charge(uint64_t nFrameAdvances, uint64_t nLoads)
+{
+	bool exceeded = false;
+	for (ScriptBudgetScope* scope = this; scope; scope = scope->_parent)
+	{
+		scope->_nFrameAdvances += nFrameAdvances;
+		scope->_nLoads += nLoads;
+		exceeded |= scope->IsExceededLocal();
+	}
+
+	if (exceeded)
+		throw ScriptBudgetExceeded();
+}
+
+bool ScriptBudgetScope::IsExceeded()
+{
+	for (ScriptBudgetScope* scope = this; scope; scope = scope->_parent)
+	{
+		if (scope->IsExceededLocal())
+			return true;
+	}
+
+	return false;
+}
+
+// Once exceeded, a scope stays exceeded so the rest of its subtree fails fast
+bool ScriptBudgetScope::IsExceededLocal()
+{
+	if (_exceeded)
+		return true;
+
+	_exceeded = (_budget.maxFrameAdvances != 0 && _nFrameAdvances > _budget.maxFrameAdvances)
+		|| (_budget.maxLoads != 0 && _nLoads > _budget.maxLoads)
+		|| (_budget.maxDuration != 0 && GetTime() - _startTime > _budget.maxDuration);
+
+	return _exceeded;
+}
+
+uint64_t ScriptBudgetScope::GetTime()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,304 @@
+#include <tasfw/ScriptProfiler.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+#include <nlohmann/json.hpp>
+
+#ifndef _MSC_VER
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
+class ScriptProfiler::MergedNode
+{
+public:
+	std::string name;
+	bool isAdhoc = false;
+	std::vector<MergedNode> children;
+	uint64_t nCalls = 0;
+	uint64_t duration = 0;
+	uint64_t nFrameAdvances = 0;
+	uint64_t nSaves = 0;
+	uint64_t nLoads = 0;
+
+	MergedNode& GetChild(const std::string& childName, bool childIsAdhoc)
+	{
+		for (MergedNode& child : children)
+		{
+			if (child.name == childName && child.isAdhoc == childIsAdhoc)
+				return child;
+		}
+
+		children.emplace_back();
+		children.back().name = childName;
+		children.back().isAdhoc = childIsAdhoc;
+		return children.back();
+	}
+
+	// Subtract children to get exclusive values, clamping at 0 in case a child finished after the parent was read
+	uint64_t GetExclusive(uint64_t MergedNode::* value) const
+	{
+		uint64_t childTotal = 0;
+		for (const MergedNode& child : children)
+			childTotal += child.*value;
+
+		return this->*value > childTotal ? this->*value - childTotal : 0;
+	}
+};
+
+std::atomic<bool> ScriptProfiler::enabled = false;
+std::mutex ScriptProfiler::threadProfilesMutex;
+std::vector<std::shared_ptr<ScriptProfiler::ThreadProfile>> ScriptProfiler::threadProfiles;
+
+void ScriptProfiler::Enable()
+{
+	enabled = true;
+}
+
+void ScriptProfiler::Disable()
+{
+	enabled = false;
+}
+
+bool ScriptProfiler::IsEnabled()
+{
+	return enabled.load(std::memory_order_relaxed);
+}
+
+void ScriptProfiler::Reset()
+{
+	std::lock_guard<std::mutex> lock(threadProfilesMutex);
+	for (auto& threadProfile : threadProfiles)
+	{
+		// Keep the nodes themselves, since scripts that are still running refer to them
+		for (Node& node : threadProfile->nodes)
+		{
+			node.nCalls = 0;
+			node.duration = 0;
+			node.nFrameAdvances = 0;
+			node.nSaves = 0;
+			node.nLoads = 0;
+		}
+
+		uint64_t time = GetTime();
+		for (StackFrame& stackFrame : threadProfile->stack)
+			stackFrame.startTime = time;
+	}
+}
+
+bool ScriptProfiler::Enter(const std::type_info& type, bool isAdhoc)
+{
+	if (!IsEnabled())
+		return false;
+
+	ThreadProfile& threadProfile = GetThreadProfile();
+	int64_t parent = threadProfile.stack.empty() ? 0 : threadProfile.stack.back().node;
+	int64_t node = -1;
+	for (int64_t child : threadProfile.nodes[parent].children)
+	{
+		if (threadProfile.nodes[child].type == type && threadProfile.nodes[child].isAdhoc == isAdhoc)
+		{
+			node = child;
+			break;
+		}
+	}
+
+	if (node == -1)
+	{
+		node = threadProfile.nodes.size();
+		threadProfile.nodes.emplace_back(type, isAdhoc);
+		threadProfile.nodes[parent].children.push_back(node);
+	}
+
+	threadProfile.stack.push_back(StackFrame{ node, GetTime() });
+	return true;
+}
+
+void ScriptProfiler::Exit(bool entered, uint64_t nFrameAdvances, uint64_t nSaves, uint64_t nLoads)
+{
+	if (!entered)
+		return;
+
+	ThreadProfile& threadProfile = GetThreadProfile();
+	StackFrame stackFrame = threadProfile.stack.back();
+	threadProfile.stack.pop_back();
+
+	Node& node = threadProfile.nodes[stackFrame.node];
+	node.nCalls++;
+	node.duration += GetTime() - stackFrame.startTime;
+	node.nFrameAdvances += nFrameAdvances;
+	node.nSaves += nSaves;
+	node.nLoads += nLoads;
+}
+
+void ScriptProfiler::WriteFoldedStacks(std::ostream& stream)
+{
+	MergedNode root = Merge();
+
+	auto writeNode = [&](auto& self, const MergedNode& node, const std::string& path) -> void
+	{
+		std::string nodePath = path.empty() ? node.name : path + ";" + node.name;
+		uint64_t exclusiveDuration = node.GetExclusive(&MergedNode::duration);
+		if (exclusiveDuration > 0)
+			stream << nodePath << " " << exclusiveDuration << "\n";
+
+		for (const MergedNode& child : node.children)
+			self(self, child, nodePath);
+	};
+
+	for (const MergedNode& child : root.children)
+		writeNode(writeNode, child, "");
+}
+
+void ScriptProfiler::WriteJsonSummary(std::ostream& stream)
+{
+	MergedNode root = Merge();
+
+	class Summary
+	{
+	public:
+		bool isAdhoc = false;
+		uint64_t nCalls = 0;
+		uint64_t inclusiveDuration = 0;
+		uint64_t exclusiveDuration = 0;
+		uint64_t inclusiveFrameAdvances = 0;
+		uint64_t exclusiveFrameAdvances = 0;
+		uint64_t inclusiveSaves = 0;
+		uint64_t exclusiveSaves = 0;
+		uint64_t inclusiveLoads = 0;
+		uint64_t exclusiveLoads = 0;
+	};
+
+	std::map<std::string, Summary> summaries;
+	std::vector<std::string> path;
+	auto summarizeNode = [&](auto& self, const MergedNode& node) -> void
+	{
+		Summary& summary = summaries[node.name];
+		summary.isAdhoc = node.isAdhoc;
+		summary.nCalls += node.nCalls;
+		summary.exclusiveDuration += node.GetExclusive(&MergedNode::duration);
+		summary.exclusiveFrameAdvances += node.GetExclusive(&MergedNode::nFrameAdvances);
+		summary.exclusiveSaves += node.GetExclusive(&MergedNode::nSaves);
+		summary.exclusiveLoads += node.GetExclusive(&MergedNode::nLoads);
+
+		// Recursive calls are already included in the outermost call
+		if (std::find(path.begin(), path.end(), node.name) == path.end())
+		{
+			summary.inclusiveDuration += node.duration;
+			summary.inclusiveFrameAdvances += node.nFrameAdvances;
+			summary.inclusiveSaves += node.nSaves;
+			summary.inclusiveLoads += node.nLoads;
+		}
+
+		path.push_back(node.name);
+		for (const MergedNode& child : node.children)
+			self(self, child);
+		path.pop_back();
+	};
+
+	uint64_t totalDuration = 0;
+	for (const MergedNode& child : root.children)
+	{
+		totalDuration += child.duration;
+		summarizeNode(summarizeNode, child);
+	}
+
+	std::vector<std::pair<std::string, Summary>> sortedSummaries(summaries.begin(), summaries.end());
+	std::stable_sort(sortedSummaries.begin(), sortedSummaries.end(),
+		[](const auto& a, const auto& b) { return a.second.exclusiveDuration > b.second.exclusiveDuration; });
+
+	nlohmann::ordered_json json;
+	json["totalDurationNs"] = totalDuration;
+	json["scripts"] = nlohmann::ordered_json::array();
+	for (const auto& [name, summary] : sortedSummaries)
+	{
+		nlohmann::ordered_json entry;
+		entry["name"] = name;
+		entry["kind"] = summary.isAdhoc ? "adhoc" : "script";
+		entry["calls"] = summary.nCalls;
+		entry["inclusiveDurationNs"] = summary.inclusiveDuration;
+		entry["exclusiveDurationNs"] = summary.exclusiveDuration;
+		entry["inclusiveFrameAdvances"] = summary.inclusiveFrameAdvances;
+		entry["exclusiveFrameAdvances"] = summary.exclusiveFrameAdvances;
+		entry["inclusiveSaves"] = summary.inclusiveSaves;
+		entry["exclusiveSaves"] = summary.exclusiveSaves;
+		entry["inclusiveLoads"] = summary.inclusiveLoads;
+		entry["exclusiveLoads"] = summary.exclusiveLoads;
+		json["scripts"].push_back(entry);
+	}
+
+	stream << json.dump(4) << "\n";
+}
+
+ScriptProfiler::ThreadProfile& ScriptProfiler::GetThreadProfile()
+{
+	// Shared with the registry so the data outlives the thread
+	thread_local std::shared_ptr<ThreadProfile> threadProfile = []()
+	{
+		auto newThreadProfile = std::make_shared<ThreadProfile>();
+		std::lock_guard<std::mutex> lock(threadProfilesMutex);
+		threadProfiles.push_back(newThreadProfile);
+		return newThreadProfile;
+	}();
+
+	return *threadProfile;
+}
+
+uint64_t ScriptProfiler::GetTime()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string ScriptProfiler::GetName(const Node& node)
+{
+	std::string name = node.type.name();
+
+#ifdef _MSC_VER
+	for (const std::string prefix : { "class ", "struct " })
+	{
+		if (name.starts_with(prefix))
+			name = name.substr(prefix.size());
+	}
+#else
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+	if (status == 0 && demangled)
+		name = demangled;
+	std::free(demangled);
+#endif
+
+	// Semicolons separate frames in folded stacks
+	std::replace(name.begin(), name.end(), ';', ',');
+	return node.isAdhoc ? "[adhoc] " + name : name;
+}
+
+ScriptProfiler::MergedNode ScriptProfiler::Merge()
+{
+	MergedNode root;
+
+	std::lock_guard<std::mutex> lock(threadProfilesMutex);
+	for (auto& threadProfile : threadProfiles)
+	{
+		auto mergeNode = [&](auto& self, MergedNode& mergedNode, int64_t nodeIndex) -> void
+		{
+			for (int64_t childIndex : threadProfile->nodes[nodeIndex].children)
+			{
+				const Node& child = threadProfile->nodes[childIndex];
+				MergedNode& mergedChild = mergedNode.GetChild(GetName(child), child.isAdhoc);
+				mergedChild.nCalls += child.nCalls;
+				mergedChild.duration += child.duration;
+				mergedChild.nFrameAdvances += child.nFrameAdvances;
+				mergedChild.nSaves += child.nSaves;
+				mergedChild.nLoads += child.nLoads;
+
+				self(self, mergedChild, childIndex);
+			}
+		};
+
+		mergeNode(mergeNode, root, 0);
+	}
+
+	return root;
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <unordered_map>
 #include <vector>
 #include "tasfw/Resource.hpp"
@@ -13,6 +14,7 @@ public:
 	std::filesystem::path dllPath;
 	CountryCode countryCode;
 	bool lightweight; // true = faster, but accuracy not guaranteed in all situations
+	std::filesystem::path checkpointCacheDirectory; // optional, enables on-disk caching of long loads. States are only reused while the DLL is loaded at the same address.
 };
 
 constexpr int pagesize = 4096;
@@ -47,6 +49,12 @@ public:
 	void* addr(const char* symbol) const;
 	std::size_t getStateSize(const LibSm64Mem& state) const;
 	uint32_t getCurrentFrame() const;
+	uint64_t getBuildHash() const;
+	bool serialize(const LibSm64Mem& state, std::ostream& out) const;
+	bool deserialize(LibSm64Mem& state, std::istream& in) const;
+
+private:
+	uint64_t buildHash = 0;
 };
 
 #endif
\ No newline at end of file
@@ -30,6 +30,14 @@ static void handler(int sig, siginfo_t* si, void* unused)
 LibSm64::LibSm64(const LibSm64Config& config) : config(config), dll(config.dllPath)
 {
 	slotManager._saveMemLimit = int64_t(8000) * 1024 * 1024; //8 GB
+	checkpointCacheDirectory = config.checkpointCacheDirectory;
+
+	// Saved states are only compatible with the exact same DLL and save mode
+	std::ifstream dllFile(config.dllPath, std::ios::binary);
+	std::vector<char> dllBytes((std::istreambuf_iterator<char>(dllFile)), std::istreambuf_iterator<char>());
+	buildHash = HashBytes(dllBytes.data(), dllBytes.size());
+	buildHash = HashBytes(&config.countryCode, sizeof(config.countryCode), buildHash);
+	buildHash = HashBytes(&config.lightweight, sizeof(config.lightweight), buildHash);
 
 	// constructor of SharedLib will throw if it can't load
 	void* processID = dll.get("sm64_init");
@@ -48,6 +56,11 @@ LibSm64::LibSm64(const LibSm64Config& config) : config(config), dll(config.dllPa
 		SegVal {".data", sections[".data"].address, sections[".data"].length},
 		SegVal {".bss", sections[".bss"].address, sections[".bss"].length},
 	};
+
+	// States hold absolute pointers into the library, so they only fit the same copy of it mapped at the same address.
+	// With ASLR, or another copy of the DLL, the hash changes and cached states are not reused.
+	for (const SegVal& seg : segment)
+		buildHash = HashBytes(&seg.address, sizeof(seg.address), buildHash);
 #if !defined(_WIN32)
 
 	original_buf1.resize(segment[0].length);
@@ -175,4 +188,78 @@ std::size_t LibSm64::getStateSize(const LibSm64Mem& state) const
 uint32_t LibSm64::getCurrentFrame() const
 {
 	return *(uint32_t*)(addr("gGlobalTimer")) - 1;
-}
\ No newline at end of file
+}
+
+uint64_t LibSm64::getBuildHash() const
+{
+	return buildHash;
+}
+
+bool LibSm64::serialize(const LibSm64Mem& state, std::ostream& out) const
+{
+#if defined(_WIN32)
+	uint64_t sizes[2] = { state.buf1.size(), state.buf2.size() };
+	out.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+	out.write(reinterpret_cast<const char*>(state.buf1.data()), state.buf1.size());
+	out.write(reinterpret_cast<const char*>(state.buf2.data()), state.buf2.size());
+#else
+	// Pages are stored relative to their segment. The build hash includes the segment addresses, so they are only read back into the same mapping.
+	uint64_t nRegions = state.changed_regions.size();
+	out.write(reinterpret_cast<const char*>(&nRegions), sizeof(nRegions));
+	for (const auto& [region, data] : state.changed_regions)
+	{
+		uint64_t location[2] = { 0, 0 };
+		bool found = false;
+		for (uint64_t i = 0; i < segment.size(); i++)
+		{
+			uint8_t* base = reinterpret_cast<uint8_t*>(align_pointer(segment[i].address, pagesize));
+			uint8_t* page = reinterpret_cast<uint8_t*>(region);
+			if (page >= base && page < reinterpret_cast<uint8_t*>(segment[i].address) + segment[i].length)
+			{
+				location[0] = i;
+				location[1] = page - base;
+				found = true;
+				break;
+			}
+		}
+
+		if (!found)
+			return false;
+
+		out.write(reinterpret_cast<const char*>(location), sizeof(location));
+		out.write(reinterpret_cast<const char*>(data.data()), pagesize);
+	}
+#endif
+
+	return bool(out);
+}
+
+bool LibSm64::deserialize(LibSm64Mem& state, std::istream& in) const
+{
+#if defined(_WIN32)
+	uint64_t sizes[2] = { 0, 0 };
+	in.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+	state.buf1.resize(sizes[0]);
+	state.buf2.resize(sizes[1]);
+	in.read(reinterpret_cast<char*>(state.buf1.data()), sizes[0]);
+	in.read(reinterpret_cast<char*>(state.buf2.data()), sizes[1]);
+#else
+	uint64_t nRegions = 0;
+	in.read(reinterpret_cast<char*>(&nRegions), sizeof(nRegions));
+	for (uint64_t n = 0; n < nRegions && in; n++)
+	{
+		uint64_t location[2] = { 0, 0 };
+		in.read(reinterpret_cast<char*>(location), sizeof(location));
+		if (location[0] >= segment.size())
+			return false;
+
+		uint8_t* base = reinterpret_cast<uint8_t*>(align_pointer(segment[location[0]].address, pagesize));
+		in.read(reinterpret_cast<char*>(state.changed_regions[base + location[1]].data()), pagesize);
+	}
+
+	// Force a reset to the original segments on load, since this process may have dirtied other pages
+	state.region_count_at_save_time = UINT64_MAX;
+#endif
+
+	return bool(in);
+}
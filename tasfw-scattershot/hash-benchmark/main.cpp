@@ -0,0 +1,135 @@
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <BinaryStateBin.hpp>
+#include <StateHash.hpp>
+
+// A state bin with padding, so the filler mask has bytes to skip
+class PaddedStateBin
+{
+public:
+    int16_t x = 0;
+    int32_t y = 0;
+    int8_t action = 0;
+    int64_t z = 0;
+
+    bool operator==(const PaddedStateBin& toCompare) const
+    {
+        return x == toCompare.x && y == toCompare.y && action == toCompare.action && z == toCompare.z;
+    }
+};
+
+// The byte at a time hash state bins used before StateBinMask and HashWords
+template <class TState>
+class ByteHasher
+{
+public:
+    static uint64_t Hash(const TState& toHash)
+    {
+        std::hash<std::byte> byteHasher;
+        const auto* data = reinterpret_cast<const std::byte*>(&toHash);
+        uint64_t hashValue = 0;
+        for (std::size_t i = 0; i < sizeof(toHash); i++)
+        {
+            if (!FillerBytes.contains(static_cast<int>(i)))
+                hashValue ^= static_cast<uint64_t>(byteHasher(data[i])) + 0x9e3779b97f4a7c15ull + (hashValue << 6) + (hashValue >> 2);
+        }
+
+        return hashValue;
+    }
+
+private:
+    static std::unordered_set<int> GetFillerBytes()
+    {
+        std::unordered_set<int> fillerBytes;
+        const StateBinMask<TState>& mask = StateBinMask<TState>::Get();
+        const auto* maskBytes = reinterpret_cast<const unsigned char*>(mask.words.data());
+        for (std::size_t i = 0; i < sizeof(TState); i++)
+        {
+            if (maskBytes[i] == 0)
+                fillerBytes.insert(static_cast<int>(i));
+        }
+
+        return fillerBytes;
+    }
+
+    inline const static std::unordered_set<int> FillerBytes = GetFillerBytes();
+};
+
+// State bins with every byte from the RNG, so neither hash sees repeated inputs
+template <class TState>
+static std::vector<TState> MakeStateBins(std::size_t count)
+{
+    std::vector<TState> stateBins(count);
+    uint64_t rngState = 0;
+    for (TState& stateBin : stateBins)
+    {
+        auto* bytes = reinterpret_cast<unsigned char*>(&stateBin);
+        for (std::size_t i = 0; i < sizeof(TState); i++)
+        {
+            rngState = MixRng(rngState);
+            bytes[i] = static_cast<unsigned char>(rngState);
+        }
+    }
+
+    return stateBins;
+}
+
+template <class TState, class THash>
+static double MeasureNsPerHash(const std::vector<TState>& stateBins, int nPasses, THash hash, uint64_t& sink)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < nPasses; pass++)
+    {
+        for (const TState& stateBin : stateBins)
+            sink ^= hash(stateBin);
+    }
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (double(stateBins.size()) * nPasses);
+}
+
+template <class TState>
+static void Benchmark(const std::string& name, int nPasses, uint64_t& sink)
+{
+    std::vector<TState> stateBins = MakeStateBins<TState>(1 << 16);
+
+    // Warm up, which also builds both filler tables outside the timed loops
+    MeasureNsPerHash(stateBins, 1, ByteHasher<TState>::Hash, sink);
+    MeasureNsPerHash(stateBins, 1, HashStateBin<TState>, sink);
+
+    double byteNs = MeasureNsPerHash(stateBins, nPasses, ByteHasher<TState>::Hash, sink);
+    double wordNs = MeasureNsPerHash(stateBins, nPasses, HashStateBin<TState>, sink);
+
+    std::cout << name << " (" << sizeof(TState) << " bytes): byte hash " << byteNs << " ns, HashStateBin "
+        << wordNs << " ns, " << byteNs / wordNs << "x\n";
+}
+
+// Usage: hash-benchmark [passes]
+// Compares the hashing throughput of HashStateBin with the byte at a time hash it replaced.
+int main(int argc, char* argv[])
+{
+    int nPasses = argc > 1 ? std::stoi(argv[1]) : 200;
+    if (nPasses <= 0)
+    {
+        std::cout << "Usage: hash-benchmark [passes]\n";
+        return 1;
+    }
+
+    uint64_t sink = 0;
+    Benchmark<BinaryStateBin<16>>("BinaryStateBin<16>", nPasses, sink);
+    Benchmark<BinaryStateBin<64>>("BinaryStateBin<64>", nPasses, sink);
+    Benchmark<PaddedStateBin>("PaddedStateBin", nPasses, sink);
+
+    // Printed so the hashes can't be optimized away
+    std::cout << "Checksum: " << sink << "\n";
+    return 0;
+}
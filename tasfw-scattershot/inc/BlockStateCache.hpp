@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <tasfw/Inputs.hpp>
+
+template <class TResourceState>
+class BlockStateCacheEntry
+{
+public:
+    uint32_t tailSegment = 0; // Blocks can be replaced by a better path to the same state bin, so an entry only matches the path it was made from
+    M64Diff m64Diff; // Inputs written while decoding the block
+    TResourceState state; // Resource state at the end of the block
+};
+
+/// <summary>
+/// Bounded cache of decoded base blocks, keyed by block index. Least recently used entries are evicted first.
+/// Not thread-safe. Callers sharing a cache between threads must lock around it.
+/// </summary>
+template <class TResourceState>
+class BlockStateCache
+{
+public:
+    BlockStateCache(int64_t capacity) : capacity(capacity) {}
+
+    // Returns nullptr if the block is not cached, or was cached for a path that has since been replaced
+    std::shared_ptr<const BlockStateCacheEntry<TResourceState>> Find(int blockIndex, uint32_t tailSegment)
+    {
+        auto entry = entries.find(blockIndex);
+        if (entry == entries.end() || entry->second.first->tailSegment != tailSegment)
+            return nullptr;
+
+        recentBlocks.splice(recentBlocks.begin(), recentBlocks, entry->second.second);
+        return entry->second.first;
+    }
+
+    // Returns the entry that was replaced or evicted to make room, if any
+    std::shared_ptr<const BlockStateCacheEntry<TResourceState>> Insert(int blockIndex, std::shared_ptr<const BlockStateCacheEntry<TResourceState>> blockState)
+    {
+        if (capacity <= 0)
+            return blockState;
+
+        auto entry = entries.find(blockIndex);
+        if (entry != entries.end())
+        {
+            std::swap(entry->second.first, blockState);
+            recentBlocks.splice(recentBlocks.begin(), recentBlocks, entry->second.second);
+            return blockState;
+        }
+
+        std::shared_ptr<const BlockStateCacheEntry<TResourceState>> evicted = nullptr;
+        if (static_cast<int64_t>(entries.size()) >= capacity)
+        {
+            auto evictedEntry = entries.find(recentBlocks.back());
+            evicted = std::move(evictedEntry->second.first);
+            entries.erase(evictedEntry);
+            recentBlocks.pop_back();
+        }
+
+        recentBlocks.push_front(blockIndex);
+        entries.emplace(blockIndex, std::make_pair(std::move(blockState), recentBlocks.begin()));
+        return evicted;
+    }
+
+private:
+    int64_t capacity;
+    std::list<int> recentBlocks; // Most recently used first
+    std::unordered_map<int, std::pair<std::shared_ptr<const BlockStateCacheEntry<TResourceState>>, std::list<int>::iterator>> entries;
+};
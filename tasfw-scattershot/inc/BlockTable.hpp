@@ -0,0 +1,467 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <ChunkedArray.hpp>
+
+// Everything known about a block's state bin. Replaced as a whole, never modified.
+template <class TState>
+class BlockRecord
+{
+public:
+    TState stateBin;
+    uint64_t hash = 0; // Hash of the state bin, kept so slots can be moved when the table grows
+    uint32_t tailSegment; // Index in the segment arena
+    float fitness = 0;
+    bool isSolution = false; // Whether the block has been recorded as a solution
+    bool isPinned = false; // Never evicted. Solutions and the blocks shots start from root with.
+
+    BlockRecord(const TState& stateBin, uint64_t hash, uint32_t tailSegment, float fitness, bool isSolution, bool isPinned)
+        : stateBin(stateBin), hash(hash), tailSegment(tailSegment), fitness(fitness), isSolution(isSolution), isPinned(isPinned) {}
+};
+
+template <class TState>
+class Block
+{
+public:
+    // Not lock-free on libstdc++ or MSVC: both guard each atomic shared_ptr with a small internal lock
+    std::atomic<std::shared_ptr<const BlockRecord<TState>>> record;
+    std::atomic<uint32_t> nSelections = 0;
+    std::atomic<uint32_t> nSuccesses = 0; // Selections whose shot found at least one new block
+};
+
+/// <summary>
+/// Open-addressing table of blocks keyed by state bin hash, safe to read and update from any thread without a table-wide lock.
+/// Slots and counters are plain atomics. Records are swapped through an atomic shared_ptr, which common standard libraries
+/// implement with a short per-block lock, so reading a record may briefly wait on a writer of that same block.
+/// Block records live in chunks that are allocated as the table grows, so they never move.
+/// The slot table grows by incremental migration: once it is half full a larger one is allocated,
+/// and every lookup moves a batch of slots over, plus the slots its own key could be in, before using it.
+/// With a block limit, new blocks take the index of an evicted one instead, so memory stays fixed.
+/// When upserts are serialized, as in deterministic mode, blocks get the same indices as with a sequential table.
+/// </summary>
+template <class TState>
+class BlockTable
+{
+private:
+    class SlotTable;
+
+public:
+    static constexpr int EmptySlot = -1;
+    static constexpr int ClaimedSlot = -2;
+    static constexpr int MovedEmptySlot = -3; // Migrated to the next table. Ends a probe sequence like an empty slot.
+    static constexpr int MovedSlot = -4; // Migrated to the next table
+
+    // Rough memory cost of a block, not counting its segment
+    static constexpr int64_t BytesPerBlock = sizeof(Block<TState>) + sizeof(BlockRecord<TState>) + 4 * sizeof(int) + 64;
+
+    // A block found by Find, or the slot claimed for it if there is none
+    class Lookup
+    {
+    public:
+        int blockIndex = -1;
+        std::shared_ptr<const BlockRecord<TState>> record; // Null if the slot was claimed
+        int64_t slot = -1;
+
+    private:
+        friend class BlockTable<TState>;
+        std::shared_ptr<SlotTable> table;
+    };
+
+    // Starts with room for initialCapacity blocks. If maxBlocks is not 0, blocks are evicted past it.
+    BlockTable(int64_t initialCapacity, int64_t maxBlocks = 0)
+        : maxBlocks(maxBlocks)
+    {
+        currentTable.store(std::make_shared<SlotTable>(GetTableSize(initialCapacity)));
+    }
+
+    BlockTable(const BlockTable<TState>&) = delete;
+    BlockTable<TState>& operator= (const BlockTable<TState>&) = delete;
+
+    // Block indices in use, including any still being published
+    int64_t Size() const
+    {
+        return nBlocks.load(std::memory_order_acquire);
+    }
+
+    uint64_t GetEvictions() const
+    {
+        return nEvictions.load(std::memory_order_relaxed);
+    }
+
+    // Waits for the block to be published, which only takes as long as copying its record
+    std::shared_ptr<const BlockRecord<TState>> Get(int64_t blockIndex) const
+    {
+        const Block<TState>& block = GetBlock(blockIndex);
+        std::shared_ptr<const BlockRecord<TState>> record = block.record.load(std::memory_order_acquire);
+        while (!record)
+        {
+            std::this_thread::yield();
+            record = block.record.load(std::memory_order_acquire);
+        }
+
+        return record;
+    }
+
+    // Selection counts make rarely explored blocks the first to be evicted
+    void CountSelection(int64_t blockIndex)
+    {
+        GetBlock(blockIndex).nSelections.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void CountSuccess(int64_t blockIndex)
+    {
+        GetBlock(blockIndex).nSuccesses.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t GetSelections(int64_t blockIndex) const
+    {
+        return GetBlock(blockIndex).nSelections.load(std::memory_order_relaxed);
+    }
+
+    uint32_t GetSuccesses(int64_t blockIndex) const
+    {
+        return GetBlock(blockIndex).nSuccesses.load(std::memory_order_relaxed);
+    }
+
+    // Find the block with this state bin. If there is none, the slot it would go in is claimed,
+    // and must be passed to Insert or Release. With matchExisting false, a slot is always claimed.
+    Lookup Find(const TState& stateBin, uint64_t hash, bool matchExisting)
+    {
+        while (true)
+        {
+            std::shared_ptr<SlotTable> table = currentTable.load(std::memory_order_acquire);
+            std::shared_ptr<SlotTable> nextTable = table->next.load(std::memory_order_acquire);
+            if (nextTable)
+            {
+                // Once every slot this key could be in has moved, it can only be in the next table
+                MigrateBatch(table, nextTable);
+                MigrateProbeSequence(table, nextTable, hash);
+                table = nextTable;
+            }
+
+            Lookup lookup;
+            if (Probe(*table, stateBin, hash, matchExisting, lookup))
+            {
+                lookup.table = table;
+                return lookup;
+            }
+        }
+    }
+
+    // The record of the block with this state bin, or null if there is none. Neither claims a slot nor helps a migration,
+    // so it is only exact while nothing is being inserted, as between the commits of a deterministic run.
+    std::shared_ptr<const BlockRecord<TState>> Peek(const TState& stateBin, uint64_t hash) const
+    {
+        // A migration in progress may have moved the key to the next table
+        for (std::shared_ptr<SlotTable> table = currentTable.load(std::memory_order_acquire); table; table = table->next.load(std::memory_order_acquire))
+        {
+            for (int64_t slot = hash & (table->nSlots - 1); ; slot = (slot + 1) & (table->nSlots - 1))
+            {
+                int blockIndex = table->slots[slot].load(std::memory_order_acquire);
+                if (blockIndex == EmptySlot || blockIndex == MovedEmptySlot)
+                    break;
+
+                if (blockIndex < 0)
+                    continue;
+
+                std::shared_ptr<const BlockRecord<TState>> record = Get(blockIndex);
+                if (record->stateBin == stateBin)
+                    return record;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Give up a slot claimed by Find
+    void Release(Lookup& lookup)
+    {
+        lookup.table->slots[lookup.slot].store(EmptySlot, std::memory_order_release);
+        lookup.table = nullptr;
+    }
+
+    // Insert a block into the slot claimed by Find and return its index, or -1 if the block limit is reached
+    // and every eviction candidate is fitter. The record is only created once the block is accepted.
+    // A record that is no longer used, either the evicted block's or the new one if it was rejected after all, is put in displaced.
+    template <typename F>
+    int Insert(Lookup& lookup, float fitness, F createRecord, std::shared_ptr<const BlockRecord<TState>>& displaced)
+    {
+        displaced = nullptr;
+        std::shared_ptr<const BlockRecord<TState>> record = nullptr;
+        int blockIndex = -1;
+        if (maxBlocks != 0 && Size() >= maxBlocks)
+        {
+            // Retry if another thread changes the victim first
+            while (true)
+            {
+                std::shared_ptr<const BlockRecord<TState>> victim = nullptr;
+                blockIndex = SelectVictim(victim);
+                if (blockIndex == -1)
+                    break;
+
+                if (victim->fitness > fitness)
+                {
+                    displaced = std::move(record);
+                    Release(lookup);
+                    return -1;
+                }
+
+                if (!record)
+                    record = createRecord();
+
+                // The evicted block's slot is left behind. It fails state bin checks until the next migration drops it.
+                Block<TState>& block = GetBlock(blockIndex);
+                if (block.record.compare_exchange_strong(victim, record, std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    block.nSelections.store(0, std::memory_order_relaxed);
+                    block.nSuccesses.store(0, std::memory_order_relaxed);
+                    nEvictions.fetch_add(1, std::memory_order_relaxed);
+                    displaced = std::move(victim);
+                    break;
+                }
+            }
+        }
+
+        // Grow if there is no limit, or nothing can be evicted
+        if (blockIndex == -1)
+        {
+            if (!record)
+                record = createRecord();
+
+            int64_t newBlockIndex = nBlocks.fetch_add(1, std::memory_order_acq_rel);
+            if (newBlockIndex >= BlockArray::Capacity)
+            {
+                Release(lookup);
+                throw std::runtime_error("Block index space exhausted");
+            }
+
+            blockIndex = static_cast<int>(newBlockIndex);
+            GetBlock(blockIndex).record.store(record, std::memory_order_release);
+        }
+
+        SlotTable& table = *lookup.table;
+        table.slots[lookup.slot].store(blockIndex, std::memory_order_release);
+        if (table.nOccupied.fetch_add(1, std::memory_order_relaxed) + 1 > table.nSlots / 2)
+            Grow(lookup.table);
+
+        lookup.table = nullptr;
+        return blockIndex;
+    }
+
+    // Replace the record if it is still expected. On failure, expected is updated to the current record,
+    // which may belong to a different state bin if the block was evicted.
+    bool ReplaceRecord(int blockIndex, std::shared_ptr<const BlockRecord<TState>>& expected, std::shared_ptr<const BlockRecord<TState>> record)
+    {
+        return GetBlock(blockIndex).record.compare_exchange_strong(expected, std::move(record), std::memory_order_acq_rel, std::memory_order_acquire);
+    }
+
+private:
+    using BlockArray = ChunkedArray<Block<TState>, 1 << 14, 1 << 16>;
+    static constexpr int64_t MinTableSize = 1 << 10;
+    static constexpr int64_t MigrationBatchSize = 64;
+    static constexpr int EvictionCandidates = 8;
+
+    class SlotTable
+    {
+    public:
+        int64_t nSlots;
+        std::unique_ptr<std::atomic<int>[]> slots;
+        std::atomic<int64_t> nOccupied = 0; // Including slots of evicted blocks
+        std::atomic<int64_t> migrationCursor = 0;
+        std::atomic<int64_t> nMigrated = 0;
+        std::atomic<std::shared_ptr<SlotTable>> next;
+
+        SlotTable(int64_t nSlots) : nSlots(nSlots), slots(std::make_unique<std::atomic<int>[]>(nSlots))
+        {
+            for (int64_t slot = 0; slot < nSlots; slot++)
+                slots[slot].store(EmptySlot, std::memory_order_relaxed);
+        }
+    };
+
+    int64_t maxBlocks;
+    BlockArray blocks;
+    std::atomic<int64_t> nBlocks = 0;
+    std::atomic<uint64_t> nEvictions = 0;
+    std::atomic<uint64_t> nVictimSamples = 0;
+    std::atomic<std::shared_ptr<SlotTable>> currentTable;
+
+    static int64_t GetTableSize(int64_t nBlocks)
+    {
+        int64_t tableSize = MinTableSize;
+        while (tableSize < 2 * nBlocks)
+            tableSize *= 2;
+
+        return tableSize;
+    }
+
+    Block<TState>& GetBlock(int64_t blockIndex) const
+    {
+        return blocks[blockIndex];
+    }
+
+    // Returns false if the table is being migrated and the key may already have moved
+    bool Probe(SlotTable& table, const TState& stateBin, uint64_t hash, bool matchExisting, Lookup& lookup)
+    {
+        int64_t slot = hash & (table.nSlots - 1);
+        while (true)
+        {
+            int blockIndex = table.slots[slot].load(std::memory_order_acquire);
+            if (blockIndex == ClaimedSlot)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            if (blockIndex == MovedEmptySlot || blockIndex == MovedSlot)
+                return false;
+
+            if (blockIndex == EmptySlot)
+            {
+                // Another thread may have taken the slot since it was loaded, in which case look at it again
+                if (!table.slots[slot].compare_exchange_strong(blockIndex, ClaimedSlot, std::memory_order_acq_rel))
+                    continue;
+
+                lookup.slot = slot;
+                return true;
+            }
+
+            if (matchExisting)
+            {
+                std::shared_ptr<const BlockRecord<TState>> record = Get(blockIndex);
+                if (record->stateBin == stateBin) // False indicates a hash collision or the slot of an evicted block
+                {
+                    lookup.blockIndex = blockIndex;
+                    lookup.record = std::move(record);
+                    lookup.slot = slot;
+                    return true;
+                }
+            }
+
+            slot = (slot + 1) & (table.nSlots - 1);
+        }
+    }
+
+    // Sized for the blocks in use, so a table full of evicted blocks' slots is rebuilt at the same size
+    void Grow(const std::shared_ptr<SlotTable>& table)
+    {
+        if (currentTable.load(std::memory_order_acquire) != table || table->next.load(std::memory_order_acquire))
+            return;
+
+        std::shared_ptr<SlotTable> expected = nullptr;
+        table->next.compare_exchange_strong(expected, std::make_shared<SlotTable>(GetTableSize(2 * Size())), std::memory_order_acq_rel);
+    }
+
+    void MigrateBatch(const std::shared_ptr<SlotTable>& table, const std::shared_ptr<SlotTable>& nextTable)
+    {
+        int64_t start = table->migrationCursor.fetch_add(MigrationBatchSize, std::memory_order_relaxed);
+        for (int64_t slot = start; slot < std::min(start + MigrationBatchSize, table->nSlots); slot++)
+            MigrateSlot(table, nextTable, slot);
+    }
+
+    void MigrateProbeSequence(const std::shared_ptr<SlotTable>& table, const std::shared_ptr<SlotTable>& nextTable, uint64_t hash)
+    {
+        for (int64_t slot = hash & (table->nSlots - 1); MigrateSlot(table, nextTable, slot); slot = (slot + 1) & (table->nSlots - 1)) {}
+    }
+
+    // Returns false if the slot ended a probe sequence. The thread that migrates the last slot swaps in the next table.
+    bool MigrateSlot(const std::shared_ptr<SlotTable>& table, const std::shared_ptr<SlotTable>& nextTable, int64_t slot)
+    {
+        while (true)
+        {
+            int blockIndex = table->slots[slot].load(std::memory_order_acquire);
+            if (blockIndex == MovedEmptySlot || blockIndex == MovedSlot)
+                return blockIndex == MovedSlot;
+
+            if (blockIndex == ClaimedSlot)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            if (blockIndex != EmptySlot)
+                CopySlot(*nextTable, blockIndex);
+
+            int movedSlot = blockIndex == EmptySlot ? MovedEmptySlot : MovedSlot;
+            if (!table->slots[slot].compare_exchange_strong(blockIndex, movedSlot, std::memory_order_acq_rel))
+                continue;
+
+            if (table->nMigrated.fetch_add(1, std::memory_order_acq_rel) + 1 == table->nSlots)
+            {
+                std::shared_ptr<SlotTable> expected = table;
+                currentTable.compare_exchange_strong(expected, nextTable, std::memory_order_acq_rel);
+            }
+
+            return movedSlot == MovedSlot;
+        }
+    }
+
+    // Slots are placed by the block's current record, so slots of evicted blocks are merged into the one of the block that replaced it
+    void CopySlot(SlotTable& table, int blockIndex)
+    {
+        int64_t slot = Get(blockIndex)->hash & (table.nSlots - 1);
+        while (true)
+        {
+            int slotBlockIndex = table.slots[slot].load(std::memory_order_acquire);
+            if (slotBlockIndex == blockIndex)
+                return;
+
+            if (slotBlockIndex == ClaimedSlot)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Only a stale copy can find the next table already migrating, and the slot was copied by whoever moved it
+            if (slotBlockIndex == MovedEmptySlot || slotBlockIndex == MovedSlot)
+                return;
+
+            if (slotBlockIndex == EmptySlot)
+            {
+                if (!table.slots[slot].compare_exchange_strong(slotBlockIndex, blockIndex, std::memory_order_acq_rel))
+                    continue;
+
+                table.nOccupied.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            slot = (slot + 1) & (table.nSlots - 1);
+        }
+    }
+
+    // The least fit of a few sampled blocks, preferring the least selected on ties. Sampling uses a counter instead of a
+    // thread's RNG, so serialized upserts evict the same blocks. Returns -1 if no sampled block can be evicted.
+    int SelectVictim(std::shared_ptr<const BlockRecord<TState>>& victim)
+    {
+        int64_t size = Size();
+        int victimIndex = -1;
+        uint32_t victimSelections = 0;
+        for (int i = 0; i < EvictionCandidates; i++)
+        {
+            uint64_t sample = nVictimSamples.fetch_add(1, std::memory_order_relaxed) + 0x9e3779b97f4a7c15ull;
+            sample = (sample ^ (sample >> 30)) * 0xbf58476d1ce4e5b9ull;
+            sample = (sample ^ (sample >> 27)) * 0x94d049bb133111ebull;
+            sample ^= sample >> 31;
+
+            int candidateIndex = static_cast<int>(sample % size);
+            const Block<TState>& block = GetBlock(candidateIndex);
+            std::shared_ptr<const BlockRecord<TState>> candidate = block.record.load(std::memory_order_acquire);
+            if (!candidate || candidate->isPinned)
+                continue;
+
+            uint32_t candidateSelections = block.nSelections.load(std::memory_order_relaxed);
+            if (victimIndex == -1 || candidate->fitness < victim->fitness
+                || (candidate->fitness == victim->fitness && candidateSelections < victimSelections))
+            {
+                victimIndex = candidateIndex;
+                victim = std::move(candidate);
+                victimSelections = candidateSelections;
+            }
+        }
+
+        return victimIndex;
+    }
+};
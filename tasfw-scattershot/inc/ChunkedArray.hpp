@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/// <summary>
+/// Fixed-capacity array whose elements live in chunks allocated on first use, so elements never move
+/// and a large index space costs nothing until it is used. New elements are value-initialized.
+/// Elements can be reached from any thread without locking. If two threads race to allocate a chunk, the loser frees its own.
+/// </summary>
+template <class T, int64_t ChunkSize, int64_t MaxChunks>
+class ChunkedArray
+{
+public:
+    static constexpr int64_t Capacity = ChunkSize * MaxChunks;
+
+    ChunkedArray() : chunks(std::make_unique<std::atomic<T*>[]>(MaxChunks))
+    {
+        for (int64_t chunk = 0; chunk < MaxChunks; chunk++)
+            chunks[chunk].store(nullptr, std::memory_order_relaxed);
+    }
+
+    ChunkedArray(const ChunkedArray&) = delete;
+    ChunkedArray& operator= (const ChunkedArray&) = delete;
+
+    ~ChunkedArray()
+    {
+        for (int64_t chunk = 0; chunk < MaxChunks; chunk++)
+            delete[] chunks[chunk].load(std::memory_order_relaxed);
+    }
+
+    // Allocates the element's chunk if needed
+    T& operator[](int64_t index) const
+    {
+        std::atomic<T*>& chunkPointer = chunks[index / ChunkSize];
+        T* chunk = chunkPointer.load(std::memory_order_acquire);
+        if (!chunk)
+        {
+            T* newChunk = new T[ChunkSize]();
+            if (chunkPointer.compare_exchange_strong(chunk, newChunk, std::memory_order_acq_rel, std::memory_order_acquire))
+                chunk = newChunk;
+            else
+                delete[] newChunk;
+        }
+
+        return chunk[index % ChunkSize];
+    }
+
+    // Returns nullptr if the element's chunk hasn't been allocated yet
+    T* Find(int64_t index) const
+    {
+        T* chunk = chunks[index / ChunkSize].load(std::memory_order_acquire);
+        return chunk ? &chunk[index % ChunkSize] : nullptr;
+    }
+
+private:
+    std::unique_ptr<std::atomic<T*>[]> chunks;
+};
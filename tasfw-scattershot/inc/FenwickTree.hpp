@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <ChunkedArray.hpp>
+
+/// <summary>
+/// Fenwick tree of non-negative weights for sampling an index in proportion to its weight in O(log n).
+/// Weights can be set from any thread without locking. Nodes live in a ChunkedArray,
+/// so the tree covers the whole block index space without allocating it up front.
+/// Weights are stored in fixed point, so sums stay exact and the total returns to 0 once every weight is cleared,
+/// however many updates came before. They are rounded to 1/4096, with positive weights kept at least that, and capped at 2^20.
+/// Readers may see a sample that is off by updates in progress, and should check what they get.
+/// </summary>
+class FenwickTree
+{
+public:
+    static constexpr int64_t Capacity = int64_t(1) << 30;
+    static constexpr int64_t UnitsPerWeight = int64_t(1) << 12;
+    static constexpr int64_t MaxUnits = int64_t(1) << 32; // Keeps the total of a full tree within 2^62
+
+    FenwickTree() = default;
+
+    FenwickTree(const FenwickTree&) = delete;
+    FenwickTree& operator= (const FenwickTree&) = delete;
+
+    double Get(int64_t index) const
+    {
+        return double(Load(values, index)) / UnitsPerWeight;
+    }
+
+    // Sum of all weights, in units of 1/UnitsPerWeight
+    int64_t TotalUnits() const
+    {
+        return Load(nodes, Capacity - 1);
+    }
+
+    // Concurrent sets of the same index leave the tree consistent with whichever weight is stored last
+    void Set(int64_t index, double weight)
+    {
+        int64_t units = ToUnits(weight);
+        int64_t delta = units - values[index].exchange(units, std::memory_order_acq_rel);
+        if (delta == 0)
+            return;
+
+        for (int64_t node = index + 1; node <= Capacity; node += node & -node)
+            nodes[node - 1].fetch_add(delta, std::memory_order_acq_rel);
+    }
+
+    // Index whose range of cumulative weight contains target, for target in [0, TotalUnits()).
+    // Returns -1 if target is past the total, which can happen when weights are lowered after reading it.
+    int64_t Find(int64_t target) const
+    {
+        int64_t position = 0;
+        for (int64_t step = Capacity; step > 0; step >>= 1)
+        {
+            if (position + step > Capacity)
+                continue;
+
+            int64_t nodeWeight = Load(nodes, position + step - 1);
+            if (nodeWeight <= target)
+            {
+                position += step;
+                target -= nodeWeight;
+            }
+        }
+
+        return position < Capacity ? position : -1;
+    }
+
+private:
+    static constexpr int64_t ChunkSize = 1 << 14;
+    using Units = ChunkedArray<std::atomic<int64_t>, ChunkSize, Capacity / ChunkSize>;
+
+    Units values;
+    Units nodes;
+
+    static int64_t ToUnits(double weight)
+    {
+        if (!(weight > 0))
+            return 0;
+
+        return std::clamp<int64_t>(std::llround(std::min(weight * UnitsPerWeight, double(MaxUnits))), 1, MaxUnits);
+    }
+
+    // Unallocated chunks read as 0
+    static int64_t Load(const Units& units, int64_t index)
+    {
+        const std::atomic<int64_t>* value = units.Find(index);
+        return value ? value->load(std::memory_order_acquire) : 0;
+    }
+};
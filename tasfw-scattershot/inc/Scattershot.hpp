@@ -15,6 +15,16 @@
 #include <fstream>
 #include <string>
 #include <MovementOption.hpp>
+#include <BlockStateCache.hpp>
+#include <BlockTable.hpp>
+#include <FenwickTree.hpp>
+#include <SegmentArena.hpp>
+#include <SegmentDiffStore.hpp>
+#include <SelectionPolicy.hpp>
+#include <ShotScheduler.hpp>
+#include <StateHash.hpp>
+#include <TelemetrySink.hpp>
+#include <UpsertLog.hpp>
 #include <algorithm>
 #include <functional>
 
@@ -30,11 +40,10 @@ public:
     inline static const char* Print = "print";
     inline static const char* Solutions = "solutions";
     inline static const char* TotalShots = "totalshots";
-    inline static const char* Blocks = "blocks";
-    inline static const char* CsvCounters = "csvcounters";
-    inline static const char* CsvExport = "csvexport";
     inline static const char* InputSolutions = "inputsolutions";
     inline static const char* ScriptCounters = "scriptcounters";
+    inline static const char* BlockStateCache = "blockstatecache";
+    inline static const char* SegmentDiffs = "segmentdiffs";
 };
 
 template <class TState, derived_from_specialization_of<Resource> TResource,
@@ -71,8 +80,6 @@ template <class TState,
     typename... TStateTrackerParams>
 class ScattershotBuilderImport;
 
-class Segment;
-
 template <class TState>
 class Block;
 
@@ -82,7 +89,7 @@ public:
     int StartFrame;
     int PelletMaxScripts;
     int PelletMaxFrameDistance;
-    int MaxBlocks;
+    int MaxBlocks; // Blocks the block store starts with room for. It grows past this as needed.
     int TotalThreads;
     long long MaxShots;
     int PelletsPerShot;
@@ -92,9 +99,21 @@ public:
     int MaxSolutions;
     int Seed;
     bool FitnessTieGoesToNewBlock;
-    bool Deterministic;
+    bool Deterministic; // Same blocks and solutions on every run with the same seed and thread count
+    int ShotsPerEpoch = 16; // In deterministic mode, shots per thread between commits of the upserts they found. Epochs are sized by TotalThreads, not by how many workers run them. Runs stop on a commit, so they can overshoot MaxShots by an epoch.
     uint32_t CsvSamplePeriod; // Every nth new block per thread will be printed to a CSV. Set to 0 to disable CSV export.
+    uint64_t TrackedStateMemoryBudget = 0; // Bytes of tracked states each thread keeps before evicting older ones. Set to 0 for no limit.
+    ScriptBudget PelletBudget = ScriptBudget(); // Frame advances, loads and time a single pellet may use. Ignored in deterministic mode.
+    int64_t BlockStateCacheSize = 0; // Decoded base blocks each thread keeps the savestate of, so shots start with a load instead of a replay. Set to 0 to disable.
+    int BlockStateCacheMinDepth = 4; // Shallower blocks are cheap to replay and are not cached
+    bool ShareBlockStateCache = false; // Keep one cache of BlockStateCacheSize for all threads. Only allowed for resources with RelocatableStates.
+    bool RecordSegmentDiffs = true; // Decode blocks by replaying each segment's recorded inputs. Set to false to save memory by re-running the scripts instead.
+    uint64_t BlockMemoryBudget = 0; // Approximate bytes of blocks and segments to keep before evicting the least fit blocks. Only each block and its own tail segment are counted, not ancestor segments, slot tables, selection weights or recorded segment inputs. Set to 0 for no limit.
+    bool ReclaimSegments = false; // Reuse the segments of replaced and evicted blocks once no thread can still be reading them. Needed for BlockMemoryBudget to bound segment memory.
+    std::shared_ptr<const SelectionPolicy> BaseBlockSelection = std::make_shared<UniformSelection>(); // How base blocks are weighted when a shot doesn't start from root
     std::filesystem::path M64Path;
+    bool BinaryTelemetry = false; // Also write the CSV rows in the binary columnar format, to a .sstel file next to the CSV. See TelemetryFormat.hpp.
+    int TelemetryBufferRows = 4096; // CSV rows each thread can queue for the telemetry writer before waiting on it
     std::string CsvOutputDirectory;
     std::vector<std::filesystem::path> ResourcePaths;
 
@@ -103,36 +122,6 @@ public:
     void SetResourcePaths(const TContainer& container);
 };
 
-class Segment
-{
-public:
-    std::shared_ptr<Segment> parent;
-    uint64_t seed;
-    uint8_t nScripts;
-    uint8_t depth;
-    uint16_t pipedDiff1Index = 0;
-
-    bool operator==(const Segment&) const = default;
-
-    Segment(std::shared_ptr<Segment> parent, uint64_t seed, uint8_t nScripts, uint16_t pipedDiff1Index)
-        : parent(parent), seed(seed), nScripts(nScripts), pipedDiff1Index(pipedDiff1Index)
-    {
-        if (parent == nullptr)
-            depth = 0;
-        else
-            depth = parent->depth + 1;
-    }
-};
-
-template <class TState>
-class Block
-{
-public:
-    std::shared_ptr<Segment> tailSegment;
-    TState stateBin;
-    float fitness;
-};
-
 template <class TOutputState>
 class ScattershotSolution
 {
@@ -207,18 +196,15 @@ public:
 private:
     // Global State
     std::unordered_set<int> ActiveThreads;
-    std::vector<Block<TState>> Blocks;
-    std::vector<int> BlockIndices; // Indexed by state bin hash
+    BlockTable<TState> Blocks;
+    FenwickTree SelectionWeights;
     std::map<int, ScattershotSolution<TOutputState>> Solutions;
     const std::vector<ScattershotSolution<TOutputState>>& InputSolutions;
     uint16_t InputSolutionsIndex = 0;
 
     std::string CsvFileName;
-    std::ofstream Csv;
-    int CsvSampleFrequency;
-    int64_t CsvCounter = 0;
-    int64_t CsvRows = -1; // Print this each merge so analysis can be run at the same time w/o dealing with partial rows
-    bool CsvEnabled = false;
+    std::string TelemetryFileName;
+    TelemetrySink Telemetry; // Opened once the CSV labels are known
 
     uint64_t TotalShots = 0;
     uint64_t ScriptCount = 0;
@@ -226,27 +212,60 @@ private:
     uint64_t RedundantScripts = 0;
     uint64_t NovelScripts = 0;
 
+    BlockStateCache<decltype(TResource::startSave)> SharedBlockStateCache;
+    SegmentArena Segments;
+    SegmentDiffStore SegmentDiffs;
+    uint64_t BlockStateCacheHits = 0;
+    uint64_t BlockStateCacheMisses = 0;
+
+    std::vector<UpsertLog> UpsertLogs; // One per thread, only used in deterministic mode
+    bool StopAfterCommit = false; // Decided on each commit so every thread of a deterministic run stops after the same epoch
+    ShotScheduler Shots; // Deals out the shots of each epoch in deterministic mode
+    uint64_t NextShot = 0;
+
     void PrintStatus();
+    bool IsBetterRecord(const BlockRecord<TState>& record, float fitness, bool isSolution) const;
+    bool IsNovel(const TState& stateBin, bool isSolution, float fitness);
+    void CommitUpserts();
+    void DealShots();
+    void UpdateSelectionWeight(int blockIndex);
+    void RecordBaseBlockResult(int blockIndex, const TState& stateBin, bool countSelection, bool countSuccess);
     bool UpsertBlock(TState stateBin, bool isSolution, ScattershotSolution<TOutputState> solution, float fitness,
-        std::shared_ptr<Segment> parentSegment, uint8_t nScripts, uint64_t segmentSeed, uint16_t pipedDiff1Index);
+        uint32_t parentSegment, uint8_t nScripts, uint64_t segmentSeed, uint16_t pipedDiff1Index,
+        const M64Diff& segmentDiff = M64Diff(), int64_t segmentEndFrame = -1);
+    uint32_t CreateSegment(uint32_t parentSegment, uint8_t nScripts, uint64_t segmentSeed, uint16_t pipedDiff1Index,
+        const M64Diff& segmentDiff, int64_t segmentEndFrame);
 
     template <typename T>
     uint64_t GetHash(const T& toHash, bool ignoreFillerBytes)
     {
-        std::hash<std::byte> byteHasher;
-        const auto* data = reinterpret_cast<const std::byte*>(&toHash);
-        uint64_t hashValue = 0;
-        for (std::size_t i = 0; i < sizeof(toHash); i++)
+        // Only state bins have filler bytes to skip
+        if constexpr (std::is_same_v<T, TState>)
         {
-            if (ignoreFillerBytes || !FillerBytes.contains(i))
-                hashValue ^= static_cast<uint64_t>(byteHasher(data[i])) + 0x9e3779b97f4a7c15ull + (hashValue << 6) + (hashValue >> 2);
+            if (!ignoreFillerBytes)
+                return HashStateBin(toHash);
         }
 
-        return hashValue;
+        return HashWords(toHash);
     }
 
     void OpenCsv();
 
+    // Blocks that fit in the memory budget, or 0 for no limit. A budget too small for one block still keeps one, not none.
+    static int64_t GetBlockLimit(const Configuration& config)
+    {
+        if (config.BlockMemoryBudget == 0)
+            return 0;
+
+        return std::max<int64_t>(config.BlockMemoryBudget / (BlockTable<TState>::BytesPerBlock + sizeof(Segment)), 1);
+    }
+
+    // Every worker holds a resource for the whole run, so threads past the resource count would have nothing to do
+    static int GetWorkerCount(const Configuration& config)
+    {
+        return std::min<int>(config.TotalThreads, config.ResourcePaths.size());
+    }
+
     template <typename F>
     void MultiThread(int nThreads, F func);
 
@@ -254,17 +273,25 @@ private:
         requires std::same_as<std::invoke_result_t<F, Scattershot<TState, TResource, TStateTracker, TOutputState>&, M64&, int>, ScriptStatus<TScattershotThread>>
     static std::vector<ScattershotSolution<TOutputState>> RunBase(const Configuration& configuration, const std::vector<ScattershotSolution<TOutputState>>& inputSolutions, F scriptRunner)
     {
+        if (configuration.ResourcePaths.empty())
+            throw std::runtime_error("Scattershot needs at least one resource path");
+
+        if (configuration.TotalThreads <= 0)
+            throw std::runtime_error("TotalThreads must be positive");
+
         auto start = std::chrono::high_resolution_clock::now();
         
         auto scattershot = Scattershot(configuration, inputSolutions);
         scattershot.OpenCsv();
 
+        int nWorkers = GetWorkerCount(configuration);
+
         std::vector<ScriptStatus<TScattershotThread>> statuses;
         std::vector<uint64_t> totalCycleCounts;
-        scattershot.MultiThread(configuration.TotalThreads, [&]()
+        scattershot.MultiThread(nWorkers, [&]()
             {
                 int threadId = omp_get_thread_num();
-                if (threadId < configuration.ResourcePaths.size())
+                if (static_cast<size_t>(threadId) < configuration.ResourcePaths.size())
                 {
                     M64 m64 = M64(configuration.M64Path);
                     m64.load();
@@ -281,7 +308,7 @@ private:
                 }
             });
 
-        printf("Found %d solutions in %d shots.\n", scattershot.Solutions.size(), scattershot.TotalShots);
+        printf("Found %llu solutions in %llu shots.\n", (unsigned long long)scattershot.Solutions.size(), (unsigned long long)scattershot.TotalShots);
 
         std::vector<ScattershotSolution<TOutputState>> solutions;
         solutions.reserve(scattershot.Solutions.size());
@@ -321,33 +348,6 @@ private:
 
         return solutions;
     }
-
-    static std::unordered_set<int> GetStateBinRuntimeFillerBytes()
-    {
-        std::unordered_set<int> fillerBytes;
-
-        TState stateBin;
-        std::byte* binPtr = reinterpret_cast<std::byte*>(&stateBin);
-
-        // initialize to specific garbage data compatible with all primitives;
-        for (int i = 0; i < sizeof(TState); i++)
-            binPtr[i] = (std::byte)0x3f;
-
-        // Check which bytes identity depends on
-        TState stateBinCopy = stateBin;
-        std::byte* binCopyPtr = reinterpret_cast<std::byte*>(&stateBin);
-        for (int i = 0; i < sizeof(TState); i++)
-        {
-            binCopyPtr[i] = (std::byte)0x00;
-            if (stateBin == stateBinCopy)
-                fillerBytes.insert(i);
-            binCopyPtr[i] = (std::byte)0x3f;
-        }
-
-        return fillerBytes;
-    }
-
-    inline const static std::unordered_set<int> FillerBytes = GetStateBinRuntimeFillerBytes();
 };
 
 
@@ -430,7 +430,13 @@ private:
     uint64_t RngHash = 0;
     uint64_t RngHashTemp = 0;
     TState BaseBlockStateBin;
-    std::shared_ptr<Segment> BaseBlockTailSegment = nullptr;
+    int BaseBlockIndex = -1;
+    bool BaseBlockSelectionRecorded = false;
+    bool BaseBlockSuccessRecorded = false;
+    uint32_t BaseBlockTailSegment = Segment::None;
+    uint64_t CsvCounter = 0; // New blocks this thread has found since CSV export started, for sampling
+    std::vector<uint32_t> DecodedSegments; // Reused between decodes
+    BlockStateCache<decltype(TResource::startSave)> ThreadBlockStateCache;
     std::unordered_set<MovementOption> movementOptions;
 
     short startCourse;
@@ -441,7 +447,9 @@ private:
     uint64_t GetRng();
     void SetRng(uint64_t rngHash);
     void SetTempRng(uint64_t rngHash);
+    void FireShot(int shot);
     void SelectBaseBlock(int mainIteration);
+    int SampleBaseBlock(std::shared_ptr<const BlockRecord<TState>>& block);
     bool ValidateBaseBlock(int shot);
 
     void AddCsvRow(int shot);
@@ -460,28 +468,18 @@ private:
         return;
     }
 
+    // Upsert right away, or in deterministic mode once the epoch is committed. The upsert must not refer to anything that
+    // changes before then, so it should capture by value.
     template <typename F>
-    static void QueueThreadById(bool deterministic, F func)
+    void QueueUpsert(uint64_t sequence, F upsert)
     {
-        if (!deterministic)
+        if (!config.Deterministic)
         {
-            func();
+            upsert();
             return;
         }
 
-        #pragma omp barrier
-
-        int nThreads = omp_get_num_threads();
-        for (int i = 0; i < nThreads; i++)
-        {
-            if (omp_get_thread_num() == i)
-                func();
-
-            #pragma omp barrier
-            continue;
-        }
-
-        return;
+        scattershot.UpsertLogs[Id].Add(sequence, std::move(upsert));
     }
 
     bool ValidateCourseAndArea();
@@ -68,65 +68,139 @@ template <class TState, derived_from_specialization_of<Resource> TResource,
     std::derived_from<Script<TResource>> TStateTracker,
     class TOutputState>
 Scattershot<TState, TResource, TStateTracker, TOutputState>::Scattershot(const Configuration& config, const std::vector<ScattershotSolution<TOutputState>>& inputSolutions)
-    : config(config), InputSolutions(inputSolutions)
+    : config(config), InputSolutions(inputSolutions), Blocks(config.MaxBlocks, GetBlockLimit(config)),
+    Telemetry(config.TotalThreads, config.TelemetryBufferRows), SharedBlockStateCache(config.ShareBlockStateCache ? config.BlockStateCacheSize : 0), Segments(config.TotalThreads, config.ReclaimSegments),
+    UpsertLogs(config.Deterministic ? config.TotalThreads : 0), Shots(GetWorkerCount(config))
 {
-    Blocks.reserve(config.MaxBlocks);
-    BlockIndices.reserve(3 * config.MaxBlocks);
+    if (config.Deterministic && config.ShotsPerEpoch <= 0)
+        throw std::runtime_error("ShotsPerEpoch must be positive in deterministic mode");
 
-    for (int i = 0; i < BlockIndices.capacity(); i++)
-        BlockIndices.push_back(-1);
+    if (config.ShareBlockStateCache && !TResource::RelocatableStates)
+        throw std::runtime_error("ShareBlockStateCache requires a resource whose states can be loaded into other instances");
 }
 
+template <class TState, derived_from_specialization_of<Resource> TResource,
+    std::derived_from<Script<TResource>> TStateTracker,
+    class TOutputState>
+bool Scattershot<TState, TResource, TStateTracker, TOutputState>::IsBetterRecord(const BlockRecord<TState>& record, float fitness, bool isSolution) const
+{
+    // Reject improvements that are not considered solutions if the incumbent is a solution
+    if (record.isSolution && !isSolution)
+        return false;
+
+    // Override fitness check if this block is a new solution
+    return (config.FitnessTieGoesToNewBlock && fitness == record.fitness)
+        || fitness > record.fitness
+        || (isSolution && !record.isSolution);
+}
+
+// Whether UpsertBlock would take the block, judged against the blocks as of the last commit.
+// Only exact in deterministic mode, where nothing is upserted between commits.
+template <class TState, derived_from_specialization_of<Resource> TResource,
+    std::derived_from<Script<TResource>> TStateTracker,
+    class TOutputState>
+bool Scattershot<TState, TResource, TStateTracker, TOutputState>::IsNovel(const TState& stateBin, bool isSolution, float fitness)
+{
+    std::shared_ptr<const BlockRecord<TState>> record = Blocks.Peek(stateBin, GetHash(stateBin, false));
+    if (record)
+        return IsBetterRecord(*record, fitness, isSolution);
+
+    size_t nSolutions = 0;
+    #pragma omp critical (solutions)
+    {
+        nSolutions = Solutions.size();
+    }
+
+    return !isSolution || nSolutions < static_cast<size_t>(config.MaxSolutions);
+}
+
+// Applies the upserts every thread logged during the epoch in sequence order, then lets go of the segments they needed.
+// Only called by one thread while the others wait.
+template <class TState, derived_from_specialization_of<Resource> TResource,
+    std::derived_from<Script<TResource>> TStateTracker,
+    class TOutputState>
+void Scattershot<TState, TResource, TStateTracker, TOutputState>::CommitUpserts()
+{
+    UpsertLog::Commit(UpsertLogs);
+
+    int threadId = omp_get_thread_num();
+    for (UpsertLog& log : UpsertLogs)
+    {
+        for (uint32_t segment : log.pinnedSegments)
+            Segments.Release(threadId, segment);
+
+        log.pinnedSegments.clear();
+    }
+}
+
+// Deals out the next epoch. Each shot's seed only depends on the run's seed and the shot's index.
+// Only called by one thread while the others wait.
+template <class TState, derived_from_specialization_of<Resource> TResource,
+    std::derived_from<Script<TResource>> TStateTracker,
+    class TOutputState>
+void Scattershot<TState, TResource, TStateTracker, TOutputState>::DealShots()
+{
+    uint64_t nShots = uint64_t(config.ShotsPerEpoch) * config.TotalThreads;
+    Shots.Deal(NextShot, nShots, [&](uint64_t shot) { return MixRng(uint64_t(config.Seed + 173) * 5786766484692217813 + shot); });
+    NextShot += nShots;
+}
+
+// Safe to call from any thread without holding a lock
 template <class TState, derived_from_specialization_of<Resource> TResource,
     std::derived_from<Script<TResource>> TStateTracker,
     class TOutputState>
 bool Scattershot<TState, TResource, TStateTracker, TOutputState>::UpsertBlock(
     TState stateBin, bool isSolution, ScattershotSolution<TOutputState> solution, float fitness,
-    std::shared_ptr<Segment> parentSegment, uint8_t nScripts, uint64_t segmentSeed, uint16_t pipedDiff1Index)
+    uint32_t parentSegment, uint8_t nScripts, uint64_t segmentSeed, uint16_t pipedDiff1Index,
+    const M64Diff& segmentDiff, int64_t segmentEndFrame)
 {
-    if (Blocks.size() == Blocks.capacity())
-        throw std::runtime_error("Block cap reached");
+    // Hold the parent so the new segment can always refer to it. It is only gone if the base block was replaced or evicted mid-shot.
+    int threadId = omp_get_thread_num();
+    if (parentSegment != Segment::None && !Segments.TryAddReference(parentSegment))
+        return false;
 
     uint64_t stateBinHash = GetHash(stateBin, false);
-    while (true)
+    bool isRoot = parentSegment == Segment::None || pipedDiff1Index != 0;
+    uint32_t tailSegment = Segment::None;
+    bool upserted = [&]()
     {
-        int blockIndex = BlockIndices[stateBinHash % BlockIndices.size()];
-        // Check for hash collision
-        if (blockIndex == -1) 
+        while (true)
         {
-            if (isSolution && Solutions.size() >= config.MaxSolutions)
-                return false;
-
-            blockIndex = Blocks.size();
-            Blocks.emplace_back(std::make_shared<Segment>(parentSegment, segmentSeed, nScripts, pipedDiff1Index), stateBin, fitness);
-            BlockIndices[stateBinHash % BlockIndices.size()] = blockIndex;
-
-            if (isSolution)
+            // Piped-in diffs always get a block of their own
+            auto lookup = Blocks.Find(stateBin, stateBinHash, pipedDiff1Index == 0);
+            if (!lookup.record)
             {
+                size_t nSolutions = 0;
                 #pragma omp critical (solutions)
                 {
-                    Solutions[blockIndex] = solution;
+                    nSolutions = Solutions.size();
                 }
-            }
 
-            return true;
-        }
+                if (isSolution && nSolutions >= static_cast<size_t>(config.MaxSolutions))
+                {
+                    Blocks.Release(lookup);
+                    return false;
+                }
 
-        if (Blocks[blockIndex].stateBin == stateBin && pipedDiff1Index == 0) // False indicates a hash collision or piped-in diff
-        {
-            // Override fitness check if this block is a new solution
-            if ((config.FitnessTieGoesToNewBlock && fitness == Blocks[blockIndex].fitness)
-                || fitness > Blocks[blockIndex].fitness
-                || isSolution && !Solutions.contains(blockIndex))
-            {
-                // Reject improvements that are not considered solutions if the incumbent is a solution
-                if (Solutions.contains(blockIndex) && !isSolution)
+                std::shared_ptr<const BlockRecord<TState>> displaced = nullptr;
+                int blockIndex = Blocks.Insert(lookup, fitness, [&]()
+                    {
+                        return std::make_shared<const BlockRecord<TState>>(stateBin, stateBinHash,
+                            CreateSegment(parentSegment, nScripts, segmentSeed, pipedDiff1Index, segmentDiff, segmentEndFrame),
+                            fitness, isSolution, isSolution || isRoot);
+                    }, displaced);
+
+                // Releases the evicted block's segment chain
+                if (displaced)
+                    Segments.Release(threadId, displaced->tailSegment);
+
+                // Rejected because the block store is full of fitter blocks
+                if (blockIndex == -1)
                     return false;
 
-                Blocks[blockIndex].fitness = fitness;
-                Blocks[blockIndex].tailSegment = std::make_shared<Segment>(parentSegment, segmentSeed, nScripts, pipedDiff1Index);
+                UpdateSelectionWeight(blockIndex);
 
-                if (isSolution && Solutions.size() < config.MaxSolutions)
+                if (isSolution)
                 {
                     #pragma omp critical (solutions)
                     {
@@ -137,11 +211,120 @@ bool Scattershot<TState, TResource, TStateTracker, TOutputState>::UpsertBlock(
                 return true;
             }
 
-            return false;
+            // Retry until the record is replaced, or another thread's record turns out to be at least as good
+            std::shared_ptr<const BlockRecord<TState>> record = lookup.record;
+            while (IsBetterRecord(*record, fitness, isSolution))
+            {
+                bool recordSolution = false;
+                if (isSolution)
+                {
+                    #pragma omp critical (solutions)
+                    {
+                        recordSolution = Solutions.size() < static_cast<size_t>(config.MaxSolutions);
+                    }
+                }
+
+                // Only create the segment once, since it records inputs
+                if (tailSegment == Segment::None)
+                    tailSegment = CreateSegment(parentSegment, nScripts, segmentSeed, pipedDiff1Index, segmentDiff, segmentEndFrame);
+
+                bool newIsSolution = record->isSolution || recordSolution;
+                auto newRecord = std::make_shared<const BlockRecord<TState>>(stateBin, stateBinHash, tailSegment, fitness,
+                    newIsSolution, newIsSolution || record->isPinned);
+                if (Blocks.ReplaceRecord(lookup.blockIndex, record, newRecord))
+                {
+                    // The record now owns the new segment, and the replaced one no longer needs its own
+                    tailSegment = Segment::None;
+                    Segments.Release(threadId, record->tailSegment);
+                    UpdateSelectionWeight(lookup.blockIndex);
+                    if (recordSolution)
+                    {
+                        #pragma omp critical (solutions)
+                        {
+                            Solutions[lookup.blockIndex] = solution;
+                        }
+                    }
+
+                    return true;
+                }
+
+                // The block was evicted and its index reused, so look for the state bin again
+                if (!(record->stateBin == stateBin))
+                    break;
+            }
+
+            if (record->stateBin == stateBin)
+                return false;
         }
+    }();
+
+    // A segment that didn't make it into a block is freed right away
+    Segments.Release(threadId, tailSegment);
+    Segments.Release(threadId, parentSegment);
+    return upserted;
+}
+
+// Solutions are given no weight, so they are never sampled as base blocks.
+// Concurrent updates of the same block may leave a weight from a slightly older record until its next update.
+template <class TState, derived_from_specialization_of<Resource> TResource,
+    std::derived_from<Script<TResource>> TStateTracker,
+    class TOutputState>
+void Scattershot<TState, TResource, TStateTracker, TOutputState>::UpdateSelectionWeight(int blockIndex)
+{
+    std::shared_ptr<const BlockRecord<TState>> record = Blocks.Get(blockIndex);
+    double weight = 0;
+    if (!record->isSolution)
+    {
+        BlockSelectionStats stats;
+        stats.fitness = record->fitness;
+        stats.nSelections = Blocks.GetSelections(blockIndex);
+        stats.nSuccesses = Blocks.GetSuccesses(blockIndex);
+        weight = config.BaseBlockSelection ? config.BaseBlockSelection->GetWeight(stats) : 1;
+    }
+
+    SelectionWeights.Set(blockIndex, weight);
+}
 
-        stateBinHash = GetHash(stateBinHash, true); // Re-hash due to collision
+// Ignored if the block was evicted and its index reused since it was selected
+template <class TState, derived_from_specialization_of<Resource> TResource,
+    std::derived_from<Script<TResource>> TStateTracker,
+    class TOutputState>
+void Scattershot<TState, TResource, TStateTracker, TOutputState>::RecordBaseBlockResult(
+    int blockIndex, const TState& stateBin, bool countSelection, bool countSuccess)
+{
+    if ((!countSelection && !countSuccess) || !(Blocks.Get(blockIndex)->stateBin == stateBin))
+        return;
+
+    if (countSelection)
+        Blocks.CountSelection(blockIndex);
+
+    if (countSuccess)
+        Blocks.CountSuccess(blockIndex);
+
+    UpdateSelectionWeight(blockIndex);
+}
+
+// Only segments that make it into a block have their inputs recorded
+template <class TState, derived_from_specialization_of<Resource> TResource,
+    std::derived_from<Script<TResource>> TStateTracker,
+    class TOutputState>
+uint32_t Scattershot<TState, TResource, TStateTracker, TOutputState>::CreateSegment(
+    uint32_t parentSegment, uint8_t nScripts, uint64_t segmentSeed, uint16_t pipedDiff1Index,
+    const M64Diff& segmentDiff, int64_t segmentEndFrame)
+{
+    uint32_t segmentIndex = Segments.Create(omp_get_thread_num(), parentSegment, segmentSeed, nScripts, pipedDiff1Index);
+    if (segmentEndFrame == -1)
+        return segmentIndex;
+
+    Segment& segment = Segments.GetMutable(segmentIndex);
+    #pragma omp critical (segmentdiffs)
+    {
+        segment.diffOffset = SegmentDiffs.Append(segmentDiff);
     }
+    segment.diffLength = segmentDiff.frames.size();
+    segment.endFrame = static_cast<int32_t>(segmentEndFrame);
+
+    return segmentIndex;
 }
 
 template <class TState, derived_from_specialization_of<Resource> TResource,
@@ -149,7 +332,12 @@ template <class TState, derived_from_specialization_of<Resource> TResource,
     class TOutputState>
 void Scattershot<TState, TResource, TStateTracker, TOutputState>::PrintStatus()
 {
-    printf("\nCombined Loops: %d Blocks: %d Solutions: %d\n", TotalShots, Blocks.size(), Solutions.size());
+    printf("\nCombined Loops: %llu Blocks: %d Solutions: %llu\n", (unsigned long long)TotalShots, (int)Blocks.Size(), (unsigned long long)Solutions.size());
+    if (config.BlockMemoryBudget != 0)
+        printf("Evicted Blocks: %llu\n", (unsigned long long)Blocks.GetEvictions());
+
+    if (config.Deterministic)
+        printf("Stolen Shots: %llu\n", (unsigned long long)Shots.GetSteals());
 
     // Print cumulative script results
     if (ScriptCount != 0)
@@ -164,11 +352,20 @@ void Scattershot<TState, TResource, TStateTracker, TOutputState>::PrintStatus()
         }
     }
 
-    if (CsvRows != -1)
+    if (config.BlockStateCacheSize > 0)
     {
-        Csv.flush();
-        printf("CSV rows: %u\n", (unsigned int)CsvRows);
+        #pragma omp critical (blockstatecache)
+        {
+            uint64_t lookups = BlockStateCacheHits + BlockStateCacheMisses;
+            int hitRate = lookups == 0 ? 0 : double(BlockStateCacheHits) / double(lookups) * 100;
+
+            printf("Block State Cache Hits: %d%%\n", hitRate);
+        }
     }
+
+    // Rows written so far are complete, so analysis can be run at the same time by reading only that many
+    if (Telemetry.IsEnabled())
+        printf("CSV rows: %llu\n", (unsigned long long)Telemetry.GetRowsWritten());
 }
 
 template <class TState, derived_from_specialization_of<Resource> TResource,
@@ -183,15 +380,10 @@ void Scattershot<TState, TResource, TStateTracker, TOutputState>::OpenCsv()
     long long startTime = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
 
     CsvFileName = config.CsvOutputDirectory + "csv_" + std::to_string(startTime) + ".csv";
-    Csv = std::ofstream(CsvFileName);
+    if (config.BinaryTelemetry)
+        TelemetryFileName = config.CsvOutputDirectory + "csv_" + std::to_string(startTime) + ".sstel";
 
-    if (!Csv.fail())
-    {
-        CsvEnabled = true;
-        std::cout << "CSV file name: " << CsvFileName << "\n";
-    }
-    else
-        std::cout << "Unable to create CSV file.";
+    std::cout << "CSV file name: " << CsvFileName << "\n";
 }
 
 template <class TState, derived_from_specialization_of<Resource> TResource,
@@ -199,7 +391,7 @@ template <class TState, derived_from_specialization_of<Resource> TResource,
     class TOutputState>
 Scattershot<TState, TResource, TStateTracker, TOutputState>::~Scattershot()
 {
-    Csv.close();
+    Telemetry.Close();
 }
 
 #endif
@@ -9,10 +9,11 @@ template <class TState, derived_from_specialization_of<Resource> TResource,
     std::derived_from<Script<TResource>> TStateTracker,
     class TOutputState>
 ScattershotThread<TState, TResource, TStateTracker, TOutputState>::ScattershotThread(Scattershot<TState, TResource, TStateTracker, TOutputState>& scattershot)
-    : scattershot(scattershot), config(scattershot.config)
+    : scattershot(scattershot), config(scattershot.config), ThreadBlockStateCache(scattershot.config.ShareBlockStateCache ? 0 : scattershot.config.BlockStateCacheSize)
 {
     Id = omp_get_thread_num();
     SetRng((uint64_t)(Id + config.Seed + 173) * 5786766484692217813);
+    this->trackedStateBudget.maxMemory = config.TrackedStateMemoryBudget;
     
     //printf("Thread %d\n", Id);
 }
@@ -29,34 +30,57 @@ bool ScattershotThread<TState, TResource, TStateTracker, TOutputState>::executio
 {
     Initialize();
 
-    uint64_t totalShots = 0;
-    for (int shot = 0; totalShots <= config.MaxShots; shot++)
+    // Deterministic shots are dealt out in epochs, and any worker may run any shot of its epoch. Workers that run out
+    // steal from the others, so an expensive shot only holds up the commit, not the shots dealt after it.
+    if (config.Deterministic)
     {
-        // Pick a block to "fire a shot" at
-        #pragma omp critical (blocks)
-        {
-            SelectBaseBlock(shot);
-        }
+        SingleThread([&]() { scattershot.DealShots(); });
 
-        auto status = ExecuteAdhoc([&]()
+        while (true)
+        {
+            ShotTask task;
+            while (scattershot.Shots.Next(Id, task))
             {
-                DecodeBaseBlockDiffAndApply();
-
-                if (!ValidateBaseBlock(shot))
-                    return false;
+                SetRng(task.seed);
+                FireShot(static_cast<int>(task.shot));
 
-                this->Save();
-                int consecutiveFailedPellets = 0;
-                for (int segment = 0; segment < config.PelletsPerShot && consecutiveFailedPellets < config.MaxConsecutiveFailedPellets; segment++)
+                #pragma omp critical (print)
                 {
-                    if (ExecuteFromBaseBlockAndEncode(shot).executed)
-                        consecutiveFailedPellets = 0;
-                    else
-                        consecutiveFailedPellets++;
+                    uint64_t totalShots = 0;
+                    #pragma omp critical (totalshots)
+                    {
+                        totalShots = ++scattershot.TotalShots;
+                    }
+
+                    // Periodically print progress to console
+                    if (totalShots % config.ShotsPerUpdate == 0)
+                        scattershot.PrintStatus();
                 }
-                    
-                return true;
-            });
+            }
+
+            // Whether to stop is decided on commit, since the shared counters only agree between commits
+            SingleThread([&]()
+                {
+                    scattershot.CommitUpserts();
+                    scattershot.StopAfterCommit = scattershot.TotalShots >= static_cast<uint64_t>(config.MaxShots)
+                        || (config.MaxSolutions > 0 && scattershot.Solutions.size() >= static_cast<size_t>(config.MaxSolutions));
+
+                    if (!scattershot.StopAfterCommit)
+                        scattershot.DealShots();
+                });
+
+            if (scattershot.StopAfterCommit)
+                break;
+        }
+
+        scattershot.Segments.EndRead(Id);
+        return true;
+    }
+
+    uint64_t totalShots = 0;
+    for (int shot = 0; totalShots <= static_cast<uint64_t>(config.MaxShots); shot++)
+    {
+        FireShot(shot);
 
         size_t nSolutions = 0;
         bool maxShotsReached = false;
@@ -82,15 +106,46 @@ bool ScattershotThread<TState, TResource, TStateTracker, TOutputState>::executio
                 scattershot.PrintStatus();
         }
 
-        //printf("%d %d %d %d\n", status.nLoads, status.nSaves, status.nFrameAdvances, status.executionDuration);
-
         if (maxShotsReached || config.MaxSolutions > 0 && nSolutions >= config.MaxSolutions)
-            return true;
+            break;
     }
 
+    // Don't hold back segment reclamation for the threads that are still running
+    scattershot.Segments.EndRead(Id);
     return true;
 }
 
+template <class TState, derived_from_specialization_of<Resource> TResource,
+    std::derived_from<Script<TResource>> TStateTracker,
+    class TOutputState>
+void ScattershotThread<TState, TResource, TStateTracker, TOutputState>::FireShot(int shot)
+{
+    // Pick a block to "fire a shot" at
+    SelectBaseBlock(shot);
+
+    auto status = ExecuteAdhoc([&]()
+        {
+            DecodeBaseBlockDiffAndApply();
+
+            if (!ValidateBaseBlock(shot))
+                return false;
+
+            this->Save();
+            int consecutiveFailedPellets = 0;
+            for (int segment = 0; segment < config.PelletsPerShot && consecutiveFailedPellets < config.MaxConsecutiveFailedPellets; segment++)
+            {
+                if (ExecuteFromBaseBlockAndEncode(shot).executed)
+                    consecutiveFailedPellets = 0;
+                else
+                    consecutiveFailedPellets++;
+            }
+                
+            return true;
+        });
+
+    //printf("%d %d %d %d\n", status.nLoads, status.nSaves, status.nFrameAdvances, status.executionDuration);
+}
+
 template <class TState, derived_from_specialization_of<Resource> TResource,
     std::derived_from<Script<TResource>> TStateTracker,
     class TOutputState>
@@ -103,7 +158,7 @@ void ScattershotThread<TState, TResource, TStateTracker, TOutputState>::Initiali
     {
         bool finishedProcessingDiffs = false;
         uint16_t inputSolutionsIndex = 0;
-        std::shared_ptr<Segment> rootSegment = std::make_shared<Segment>(nullptr, 0, RngHash, 0);
+        uint32_t rootSegment = scattershot.CreateSegment(Segment::None, 0, 0, 0, M64Diff(), -1);
         while (true)
         {
             #pragma omp critical (inputsolutions)
@@ -112,38 +167,41 @@ void ScattershotThread<TState, TResource, TStateTracker, TOutputState>::Initiali
                 finishedProcessingDiffs = inputSolutionsIndex >= scattershot.InputSolutions.size() || inputSolutionsIndex >= 65534;
             }
 
+            if (finishedProcessingDiffs)
+                break;
+
             // Execute diff and save block
             ExecuteAdhoc([&]()
                 {
-                    if (finishedProcessingDiffs)
-                    {
-                        QueueThreadById(config.Deterministic, [&]() {});
-                        return true;
-                    }
-
                     this->Apply(scattershot.InputSolutions[inputSolutionsIndex].m64Diff);
-                    QueueThreadById(config.Deterministic, [&]()
+
+                    // Logged by input index, so the piped-in blocks get the same indices whichever thread ran them.
+                    // For the same reason the seed can't come from the thread's rng, which would leave it at a different state for its shots.
+                    TState stateBin = GetStateBinSafe();
+                    float fitness = GetStateFitnessSafe();
+                    uint64_t seed = config.Deterministic ? inputSolutionsIndex : GetRng();
+                    QueueUpsert(inputSolutionsIndex, [&scattershot = scattershot, stateBin, fitness, rootSegment, seed, inputSolutionsIndex]()
                         {
-                            #pragma omp critical (blocks)
-                            {
-                                scattershot.UpsertBlock(GetStateBinSafe(), false, ScattershotSolution<TOutputState>(),
-                                    GetStateFitnessSafe(), rootSegment, 1, GetRng(), inputSolutionsIndex + 1);
-                            }
+                            scattershot.UpsertBlock(stateBin, false, ScattershotSolution<TOutputState>(),
+                                fitness, rootSegment, 1, seed, inputSolutionsIndex + 1);
                         });
 
                     return true;
                 });
-
-            if (finishedProcessingDiffs)
-                break;
         }
+
+        if (config.Deterministic)
+            SingleThread([&]() { scattershot.CommitUpserts(); });
+
+        // The piped-in blocks hold the root segment from here on
+        scattershot.Segments.Release(Id, rootSegment);
     }
 
     SingleThread([&]()
         {
             // Initialize root block if no diffs are piped in
             if (scattershot.InputSolutions.empty())
-                scattershot.UpsertBlock(GetStateBinSafe(), false, ScattershotSolution<TOutputState>(), GetStateFitnessSafe(), nullptr, 0, RngHash, 0);
+                scattershot.UpsertBlock(GetStateBinSafe(), false, ScattershotSolution<TOutputState>(), GetStateFitnessSafe(), Segment::None, 0, RngHash, 0);
 
             AddCsvLabels();
             scattershot.PrintStatus();
@@ -181,8 +239,12 @@ void ScattershotThread<TState, TResource, TStateTracker, TOutputState>::AddCsvLa
             if (labels == "" || config.CsvSamplePeriod == 0)
                 return false;
 
-            scattershot.Csv << labels << "\n";
-            scattershot.CsvRows = 0;
+            if (!scattershot.Telemetry.Open(scattershot.CsvFileName, scattershot.TelemetryFileName, labels))
+            {
+                std::cout << "Unable to create CSV file.\n";
+                return false;
+            }
+
             AddCsvRow(0);
 
             return true;
@@ -207,33 +269,74 @@ template <class TState, derived_from_specialization_of<Resource> TResource,
     class TOutputState>
 void ScattershotThread<TState, TResource, TStateTracker, TOutputState>::SelectBaseBlock(int mainIteration)
 {
+    // The base block's segments stay readable for the whole shot, even if the block is replaced or evicted meanwhile
+    scattershot.Segments.BeginRead(Id);
+
+    // Blocks are read without a table-wide lock. The record is read once, since the block may be replaced or evicted meanwhile.
     int blockIndex = -1;
-    if (mainIteration % config.StartFromRootEveryNShots == 0)
+    std::shared_ptr<const BlockRecord<TState>> block = nullptr;
+    if (mainIteration % config.StartFromRootEveryNShots != 0)
+    {
+        int tournamentSize = config.BaseBlockSelection ? config.BaseBlockSelection->GetTournamentSize() : 1;
+        for (int i = 0; i < tournamentSize; i++)
+        {
+            std::shared_ptr<const BlockRecord<TState>> candidate = nullptr;
+            int candidateIndex = SampleBaseBlock(candidate);
+            if (candidateIndex != -1 && (blockIndex == -1 || candidate->fitness > block->fitness))
+            {
+                blockIndex = candidateIndex;
+                block = std::move(candidate);
+            }
+        }
+    }
+
+    // Start from root periodically, or if there is nothing to sample
+    if (blockIndex == -1)
     {
         if (scattershot.InputSolutions.empty())
             blockIndex = 0;
         else
             blockIndex = GetRng() % scattershot.InputSolutions.size();
+
+        block = scattershot.Blocks.Get(blockIndex);
     }
-    else
+
+    // Counted with the shot's first upsert, since selection weights only change while upserts are queued
+    BaseBlockSelectionRecorded = false;
+    BaseBlockSuccessRecorded = false;
+    BaseBlockIndex = blockIndex;
+    BaseBlockStateBin = block->stateBin;
+    BaseBlockTailSegment = block->tailSegment;
+
+    // Upserts from this shot are logged until the end of the epoch, and need the base block's segment to still be there
+    if (config.Deterministic && scattershot.Segments.TryAddReference(BaseBlockTailSegment))
+        scattershot.UpsertLogs[Id].pinnedSegments.push_back(BaseBlockTailSegment);
+}
+
+// Samples in proportion to the selection weights, so solutions are never picked. Returns -1 if there is nothing to sample.
+template <class TState, derived_from_specialization_of<Resource> TResource,
+    std::derived_from<Script<TResource>> TStateTracker,
+    class TOutputState>
+int ScattershotThread<TState, TResource, TStateTracker, TOutputState>::SampleBaseBlock(std::shared_ptr<const BlockRecord<TState>>& block)
+{
+    // A sample can land past the last block or on a new solution while other threads are updating weights
+    for (int attempt = 0; attempt < 16; attempt++)
     {
-        while (true)
-        {
-            blockIndex = GetRng() % scattershot.Blocks.size();
+        int64_t totalUnits = scattershot.SelectionWeights.TotalUnits();
+        if (totalUnits <= 0)
+            break;
 
-            // Don't explore beyond known solutions
-            bool isSolution;
-            #pragma omp critical (solutions)
-            {
-                isSolution = scattershot.Solutions.contains(blockIndex);
-            }
-            if (!isSolution)
-                break;
-        }
+        int64_t target = static_cast<int64_t>(GetRng() % static_cast<uint64_t>(totalUnits));
+        int64_t blockIndex = scattershot.SelectionWeights.Find(target);
+        if (blockIndex < 0 || blockIndex >= scattershot.Blocks.Size())
+            continue;
+
+        block = scattershot.Blocks.Get(blockIndex);
+        if (!block->isSolution)
+            return static_cast<int>(blockIndex);
     }
 
-    BaseBlockStateBin = scattershot.Blocks[blockIndex].stateBin;
-    BaseBlockTailSegment = scattershot.Blocks[blockIndex].tailSegment;
+    return -1;
 }
 
 template <class TState, derived_from_specialization_of<Resource> TResource,
@@ -260,90 +363,30 @@ template <class TState, derived_from_specialization_of<Resource> TResource,
     class TOutputState>
 void ScattershotThread<TState, TResource, TStateTracker, TOutputState>::AddCsvRow(int shot)
 {
-    bool sampled = false;
-    #pragma omp critical (csvcounters)
-    {
-        sampled = scattershot.CsvEnabled == true && scattershot.CsvRows != -1 && scattershot.CsvCounter++ % config.CsvSamplePeriod == 0;
-    }
-    
+    if (!scattershot.Telemetry.IsEnabled())
+        return;
+
+    // Counted per thread, so deciding whether to sample takes no lock
+    bool sampled = CsvCounter++ % config.CsvSamplePeriod == 0;
+
     // Check if we should force an export for the current state
     if (!sampled && !ExecuteAdhoc([&]() { return ForceAddToCsv(); }).executed)
         return;
 
-    // Get CSV row and validate cell count
     std::string row;
-    bool rowValidated = ExecuteAdhoc([&]()
+    ExecuteAdhoc([&]()
         {
-            auto labels = GetCsvLabels();
             row = GetCsvRow();
+            return true;
+        });
 
-            // Validate column count is the same
-            int labelsColumns = std::count(labels.begin(), labels.end(), ',');
-            int rowColumns = std::count(row.begin(), row.end(), ',');
-
-            return labelsColumns == rowColumns;
-        }).executed;
-
-    if (!rowValidated)
+    // Formatting and writing the row is left to the telemetry writer thread
+    if (!scattershot.Telemetry.Add(Id, shot, this->GetCurrentFrame(), sampled, std::move(row)))
     {
         #pragma omp critical (print)
         {
             std::cout << "Unable to add row to CSV. Labels/Row have different column counts.\n";
         }
-
-        return;
-    }
-
-    int retries = 0;
-    #pragma omp critical (csvexport)
-    {
-        // CSV row export retry loop
-        auto failedRowPos = scattershot.Csv.tellp();
-        for (int retries = 0; retries < 5; retries++)
-        {
-            if (retries > 0)
-            {
-                #pragma omp critical (print)
-                {
-                    #pragma omp critical (csvcounters)
-                    {
-                        std::cout << "Retrying CSV row " << scattershot.CsvRows << ".\n";
-                    }
-                }
-            }
-
-            scattershot.Csv << shot << "," << this->GetCurrentFrame() << "," << sampled << "," << row << "\n";
-            if (!scattershot.Csv.fail())
-            {
-                #pragma omp critical (csvcounters)
-                {
-                    scattershot.CsvRows++;
-                }
-
-                break;
-            }
-            else
-            {
-                #pragma omp critical (print)
-                {
-                    std::cout << "Error writing to CSV row " << scattershot.CsvRows << ": " << scattershot.Csv.rdstate() << "\n";
-                }
-
-                scattershot.Csv.close();
-                scattershot.Csv = std::ofstream(scattershot.CsvFileName);
-                scattershot.Csv.seekp(failedRowPos);
-            }
-        }
-
-        if (retries == 5)
-        {
-            #pragma omp critical (print)
-            {
-                std::cout << "Exceeded CSV export retry count. Disabling CSV export.\n";
-            }
-
-            scattershot.CsvEnabled = false;
-        }
     }
 }
 
@@ -422,16 +465,59 @@ template <class TState, derived_from_specialization_of<Resource> TResource,
     class TOutputState>
 AdhocBaseScriptStatus ScattershotThread<TState, TResource, TStateTracker, TOutputState>::DecodeBaseBlockDiffAndApply()
 {
+    auto& blockStateCache = config.ShareBlockStateCache ? scattershot.SharedBlockStateCache : ThreadBlockStateCache;
+    const Segment& baseBlockTailSegment = scattershot.Segments.Get(BaseBlockTailSegment);
+    bool cacheable = config.BlockStateCacheSize > 0 && baseBlockTailSegment.depth >= config.BlockStateCacheMinDepth;
+
+    std::shared_ptr<const BlockStateCacheEntry<decltype(TResource::startSave)>> cachedBlock = nullptr;
+    if (cacheable)
+    {
+        #pragma omp critical (blockstatecache)
+        {
+            cachedBlock = blockStateCache.Find(BaseBlockIndex, BaseBlockTailSegment);
+            if (cachedBlock)
+                scattershot.BlockStateCacheHits++;
+            else
+                scattershot.BlockStateCacheMisses++;
+        }
+    }
+
+    // Start from the cached state with a single load instead of replaying every segment
+    if (cachedBlock)
+    {
+        this->ApplyWithState(cachedBlock->m64Diff, cachedBlock->state);
+
+        AdhocBaseScriptStatus status;
+        status.executed = true;
+        status.nLoads = 1;
+        status.m64Diff = cachedBlock->m64Diff;
+        return status;
+    }
+
     int64_t postScriptFrame = -1;
     auto status = ModifyAdhoc([&]()
         {
-            std::shared_ptr<Segment> tailSegment = BaseBlockTailSegment;
-            std::vector<std::shared_ptr<Segment>> segments(tailSegment->depth);
-            for (auto currentSegment = tailSegment; currentSegment->depth > 0; currentSegment = currentSegment->parent)
-                segments[currentSegment->depth - 1] = currentSegment;
+            DecodedSegments.resize(baseBlockTailSegment.depth);
+            for (uint32_t segmentIndex = BaseBlockTailSegment; scattershot.Segments.Get(segmentIndex).depth > 0; segmentIndex = scattershot.Segments.Get(segmentIndex).parent)
+                DecodedSegments[scattershot.Segments.Get(segmentIndex).depth - 1] = segmentIndex;
 
-            for (auto& currentSegment : segments)
+            for (uint32_t segmentIndex : DecodedSegments)
             {
+                const Segment* currentSegment = &scattershot.Segments.Get(segmentIndex);
+                // Replay the recorded inputs instead of re-running the scripts that produced them
+                if (currentSegment->endFrame != -1)
+                {
+                    M64Diff segmentDiff;
+                    #pragma omp critical (segmentdiffs)
+                    {
+                        scattershot.SegmentDiffs.Read(currentSegment->diffOffset, currentSegment->diffLength, segmentDiff);
+                    }
+
+                    this->Apply(segmentDiff);
+                    this->Load(currentSegment->endFrame);
+                    continue;
+                }
+
                 SetTempRng(currentSegment->seed);
                 for (int script = 0; script < currentSegment->nScripts; script++)
                 {
@@ -439,9 +525,6 @@ AdhocBaseScriptStatus ScattershotThread<TState, TResource, TStateTracker, TOutpu
                         this->Apply(scattershot.InputSolutions[currentSegment->pipedDiff1Index - 1].m64Diff);
                     else
                         ChooseScriptAndApply();
-
-                    // This is here so the queued upserts don't block on the entire decoding
-                    QueueThreadById(config.Deterministic, [&]() {});
                 }
             }
 
@@ -453,6 +536,25 @@ AdhocBaseScriptStatus ScattershotThread<TState, TResource, TStateTracker, TOutpu
     // Note that this often does nothing. It does not hurt performance unless it rewinds.
     // TODO: Consider changing TASFW Modify methods to persist frame cursor so this isn't necessary
     this->Load(postScriptFrame);
+
+    // Cache entries hold their segment so it can't be reused for another path while cached
+    if (cacheable && status.executed && scattershot.Segments.TryAddReference(BaseBlockTailSegment))
+    {
+        auto blockState = std::make_shared<BlockStateCacheEntry<decltype(TResource::startSave)>>();
+        blockState->tailSegment = BaseBlockTailSegment;
+        blockState->m64Diff = status.m64Diff;
+        this->resource->SaveState(blockState->state);
+
+        std::shared_ptr<const BlockStateCacheEntry<decltype(TResource::startSave)>> displaced = nullptr;
+        #pragma omp critical (blockstatecache)
+        {
+            displaced = blockStateCache.Insert(BaseBlockIndex, blockState);
+        }
+
+        if (displaced)
+            scattershot.Segments.Release(Id, displaced->tailSegment);
+    }
+
     return status;
 }
 
@@ -461,7 +563,9 @@ template <class TState, derived_from_specialization_of<Resource> TResource,
     class TOutputState>
 AdhocBaseScriptStatus ScattershotThread<TState, TResource, TStateTracker, TOutputState>::ExecuteFromBaseBlockAndEncode(int shot)
 {
-    return ExecuteAdhoc([&]()
+    // How far a pellet gets within a time budget depends on timing, which would change what gets logged
+    ScriptBudget pelletBudget = config.Deterministic ? ScriptBudget() : config.PelletBudget;
+    return ExecuteAdhoc(pelletBudget, [&]()
         {
             TState prevStateBin = BaseBlockStateBin;
             uint64_t baseRngHash = RngHash;
@@ -481,6 +585,8 @@ AdhocBaseScriptStatus ScattershotThread<TState, TResource, TStateTracker, TOutpu
                 // Create and add block to list if it is new.
                 bool novelScript = false;
                 auto newStateBin = validated ? GetStateBinSafe() : TState();
+                M64Diff segmentDiff = validated && config.RecordSegmentDiffs ? this->GetDiff() : M64Diff();
+                int64_t segmentEndFrame = validated && config.RecordSegmentDiffs ? this->GetCurrentFrame() : -1;
                 //auto hash = scattershot.GetHash(newStateBin, false);
                 //if (hash == 12263244266731199609)
                     //this->ExportM64("C:\\repos\\sm64-tas-scripting\\res\\error.m64", this->GetTotalDiff().frames.rbegin()->first + 1);
@@ -488,15 +594,33 @@ AdhocBaseScriptStatus ScattershotThread<TState, TResource, TStateTracker, TOutpu
                 bool isSolution = validated ? ExecuteAdhoc([&]() { return IsSolution(); }).executed : false;
                 ScattershotSolution<TOutputState> solution = isSolution ? ScattershotSolution<TOutputState>(GetSolutionState(), this->GetTotalDiff())
                     : ScattershotSolution<TOutputState>();
-                QueueThreadById(config.Deterministic, [&]()
+                auto upsert = [&scattershot = scattershot, validated, newStateBin, isSolution, solution = std::move(solution), fitness,
+                    parentSegment = BaseBlockTailSegment, nScripts = n + 1, baseRngHash, segmentDiff = std::move(segmentDiff), segmentEndFrame]()
                     {
-                        #pragma omp critical (blocks)
+                        //if (validated && newStateBin != prevStateBin && newStateBin != BaseBlockStateBin)
+                        return validated && scattershot.UpsertBlock(newStateBin, isSolution, solution, fitness, parentSegment, nScripts, baseRngHash, 0,
+                            segmentDiff, segmentEndFrame);
+                    };
+
+                if (config.Deterministic)
+                {
+                    // The upsert waits for the end of the epoch, so whether it is novel is judged against the blocks it started from
+                    novelScript = validated && scattershot.IsNovel(newStateBin, isSolution, fitness);
+                    QueueUpsert(shot, [&scattershot = scattershot, upsert = std::move(upsert), baseBlockIndex = BaseBlockIndex,
+                        baseBlockStateBin = BaseBlockStateBin, countSelection = !BaseBlockSelectionRecorded, countSuccess = novelScript && !BaseBlockSuccessRecorded]()
                         {
-                            //if (validated && newStateBin != prevStateBin && newStateBin != BaseBlockStateBin)
-                            if (validated)
-                                novelScript = scattershot.UpsertBlock(newStateBin, isSolution, solution, fitness, BaseBlockTailSegment, n + 1, baseRngHash, 0);
-                        }
-                    });
+                            upsert();
+                            scattershot.RecordBaseBlockResult(baseBlockIndex, baseBlockStateBin, countSelection, countSuccess);
+                        });
+                }
+                else
+                {
+                    novelScript = upsert();
+                    scattershot.RecordBaseBlockResult(BaseBlockIndex, BaseBlockStateBin, !BaseBlockSelectionRecorded, novelScript && !BaseBlockSuccessRecorded);
+                }
+
+                BaseBlockSelectionRecorded = true;
+                BaseBlockSuccessRecorded |= novelScript;
 
                 // Update script result count
                 #pragma omp critical (scriptcounters)
@@ -536,7 +660,7 @@ template <class TState, derived_from_specialization_of<Resource> TResource,
 uint64_t ScattershotThread<TState, TResource, TStateTracker, TOutputState>::GetRng()
 {
     uint64_t rngHashPrev = RngHash;
-    RngHash = GetHash(RngHash);
+    RngHash = MixRng(RngHash);
     return rngHashPrev;
 }
 
@@ -554,7 +678,7 @@ template <class TState, derived_from_specialization_of<Resource> TResource,
 uint64_t ScattershotThread<TState, TResource, TStateTracker, TOutputState>::GetTempRng()
 {
     uint64_t rngHashPrev = RngHashTemp;
-    RngHashTemp = GetHash(RngHashTemp);
+    RngHashTemp = MixRng(RngHashTemp);
     return rngHashPrev;
 }
 
@@ -572,13 +696,7 @@ template <class TState, derived_from_specialization_of<Resource> TResource,
 template <typename T>
 uint64_t ScattershotThread<TState, TResource, TStateTracker, TOutputState>::GetHash(const T& toHash) const
 {
-    std::hash<std::byte> byteHasher;
-    const std::byte* data = reinterpret_cast<const std::byte*>(&toHash);
-    uint64_t hashValue = 0;
-    for (std::size_t i = 0; i < sizeof(T); i++)
-        hashValue ^= static_cast<uint64_t>(byteHasher(data[i])) + 0x9e3779b97f4a7c15ull + (hashValue << 6) + (hashValue >> 2);
-
-    return hashValue;
+    return HashWords(toHash);
 }
 
 template <class TState, derived_from_specialization_of<Resource> TResource,
@@ -629,7 +747,7 @@ void ScattershotThread<TState, TResource, TStateTracker, TOutputState>::AddMovem
     if (probability <= 0.0)
         return;
 
-    if (probability >= 1.0 || GetTempRng() % 65536 <= int(probability / 65535.0))
+    if (probability >= 1.0 || GetTempRng() % 65536 <= uint64_t(probability / 65535.0))
         movementOptions.insert(movementOption);
 }
 
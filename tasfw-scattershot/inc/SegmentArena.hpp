@@ -0,0 +1,192 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <ChunkedArray.hpp>
+
+class Segment
+{
+public:
+    static constexpr uint32_t None = std::numeric_limits<uint32_t>::max();
+
+    uint64_t seed = 0;
+    uint64_t diffOffset = 0; // Position of the segment's inputs in the segment diff store
+    uint32_t parent = None;
+    int32_t endFrame = -1; // Frame the segment ends on, or -1 if its inputs weren't recorded
+    uint32_t diffLength = 0;
+    uint16_t pipedDiff1Index = 0;
+    uint8_t nScripts = 0;
+    uint8_t depth = 0;
+
+    bool operator==(const Segment&) const = default;
+};
+
+/// <summary>
+/// Chunked, append-only arena of segments addressed by 32-bit indices, so selecting and decoding a block
+/// only reads plain indices instead of copying shared pointers.
+/// With reclamation, segments are reference counted by their children and the blocks and caches using them,
+/// and one that drops to no references is reused once every thread has started a read after it was released (epoch-based).
+/// Without reclamation, segments are never freed and references are not counted.
+/// Each thread allocates and reclaims through its own lists, so threads only share the epoch counter.
+/// </summary>
+class SegmentArena
+{
+public:
+    SegmentArena(int nThreads, bool reclaim) : nThreads(nThreads), reclaim(reclaim), threads(std::make_unique<ThreadState[]>(nThreads)) {}
+
+    SegmentArena(const SegmentArena&) = delete;
+    SegmentArena& operator= (const SegmentArena&) = delete;
+
+    const Segment& Get(uint32_t index) const
+    {
+        return GetSlot(index).segment;
+    }
+
+    // Segments allocated and not yet reclaimed
+    uint64_t Size() const
+    {
+        return nAllocated.load(std::memory_order_relaxed) - nReclaimed.load(std::memory_order_relaxed);
+    }
+
+    // The new segment holds a reference to its parent, and starts with one reference owned by the caller.
+    // Returns Segment::None if the parent has already been released by everything that used it.
+    uint32_t Create(int threadId, uint32_t parent, uint64_t seed, uint8_t nScripts, uint16_t pipedDiff1Index)
+    {
+        if (parent != Segment::None && !TryAddReference(parent))
+            return Segment::None;
+
+        ThreadState& thread = threads[threadId];
+        uint32_t index = 0;
+        if (!thread.freeSegments.empty())
+        {
+            index = thread.freeSegments.back();
+            thread.freeSegments.pop_back();
+        }
+        else
+        {
+            uint64_t newIndex = nSegments.fetch_add(1, std::memory_order_relaxed);
+            if (newIndex >= Segment::None)
+                throw std::runtime_error("Segment index space exhausted");
+
+            index = static_cast<uint32_t>(newIndex);
+        }
+
+        SegmentSlot& slot = GetSlot(index);
+        slot.segment = Segment();
+        slot.segment.parent = parent;
+        slot.segment.seed = seed;
+        slot.segment.nScripts = nScripts;
+        slot.segment.pipedDiff1Index = pipedDiff1Index;
+        slot.segment.depth = parent == Segment::None ? 0 : Get(parent).depth + 1;
+        slot.nReferences.store(1, std::memory_order_relaxed);
+        nAllocated.fetch_add(1, std::memory_order_relaxed);
+
+        return index;
+    }
+
+    // Fields other than the tree structure, such as recorded inputs, are filled in by the creator before publishing it
+    Segment& GetMutable(uint32_t index)
+    {
+        return GetSlot(index).segment;
+    }
+
+    // Fails once the segment has no references left, since it may already be waiting to be reused
+    bool TryAddReference(uint32_t index)
+    {
+        if (!reclaim)
+            return true;
+
+        std::atomic<uint32_t>& nReferences = GetSlot(index).nReferences;
+        uint32_t count = nReferences.load(std::memory_order_acquire);
+        while (count != 0)
+        {
+            if (nReferences.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+                return true;
+        }
+
+        return false;
+    }
+
+    void Release(int threadId, uint32_t index)
+    {
+        if (!reclaim || index == Segment::None)
+            return;
+
+        if (GetSlot(index).nReferences.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            threads[threadId].retiredSegments.emplace_back(index, epoch.load(std::memory_order_seq_cst));
+    }
+
+    // Segments the thread reads from here on stay valid until its next call. Also reuses what the thread released
+    // before every thread's latest read started.
+    void BeginRead(int threadId)
+    {
+        if (!reclaim)
+            return;
+
+        ThreadState& thread = threads[threadId];
+        thread.readEpoch.store(epoch.fetch_add(1, std::memory_order_seq_cst) + 1, std::memory_order_seq_cst);
+
+        uint64_t oldestReadEpoch = std::numeric_limits<uint64_t>::max();
+        for (int otherThreadId = 0; otherThreadId < nThreads; otherThreadId++)
+            oldestReadEpoch = std::min(oldestReadEpoch, threads[otherThreadId].readEpoch.load(std::memory_order_seq_cst));
+
+        // Freeing a segment releases its parent, which may retire the parent in turn
+        std::vector<std::pair<uint32_t, uint64_t>> retiredSegments;
+        std::swap(retiredSegments, thread.retiredSegments);
+        for (const auto& [index, retireEpoch] : retiredSegments)
+        {
+            if (retireEpoch >= oldestReadEpoch)
+            {
+                thread.retiredSegments.emplace_back(index, retireEpoch);
+                continue;
+            }
+
+            Release(threadId, Get(index).parent);
+            thread.freeSegments.push_back(index);
+            nReclaimed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // The thread holds no segments until its next BeginRead
+    void EndRead(int threadId)
+    {
+        threads[threadId].readEpoch.store(std::numeric_limits<uint64_t>::max(), std::memory_order_seq_cst);
+    }
+
+private:
+    static constexpr int64_t ChunkSize = 1 << 16;
+
+    class SegmentSlot
+    {
+    public:
+        Segment segment;
+        std::atomic<uint32_t> nReferences = 0;
+    };
+
+    class alignas(64) ThreadState
+    {
+    public:
+        std::atomic<uint64_t> readEpoch = std::numeric_limits<uint64_t>::max(); // Not reading
+        std::vector<std::pair<uint32_t, uint64_t>> retiredSegments; // With the epoch they were released in
+        std::vector<uint32_t> freeSegments;
+    };
+
+    int nThreads;
+    bool reclaim;
+    ChunkedArray<SegmentSlot, ChunkSize, (int64_t(1) << 32) / ChunkSize> slots;
+    std::unique_ptr<ThreadState[]> threads;
+    std::atomic<uint64_t> nSegments = 0;
+    std::atomic<uint64_t> nAllocated = 0;
+    std::atomic<uint64_t> nReclaimed = 0;
+    std::atomic<uint64_t> epoch = 0;
+
+    SegmentSlot& GetSlot(uint32_t index) const
+    {
+        return slots[index];
+    }
+};
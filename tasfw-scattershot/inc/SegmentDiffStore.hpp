@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <tasfw/Inputs.hpp>
+
+/// <summary>
+/// Append-only store of the inputs each segment wrote, so blocks can be decoded by replaying inputs instead of re-running scripts.
+/// Frames are packed into fixed-size chunks, so appending never moves frames that were already stored.
+/// Not thread-safe. Callers sharing a store between threads must lock around it.
+/// </summary>
+class SegmentDiffStore
+{
+public:
+    // Returns the offset of the first stored frame
+    uint64_t Append(const M64Diff& m64Diff)
+    {
+        uint64_t offset = size;
+        for (const auto& [frame, inputs] : m64Diff.frames)
+        {
+            if (size % ChunkSize == 0)
+                chunks.push_back(std::make_unique<RecordedFrame[]>(ChunkSize));
+
+            chunks[size / ChunkSize][size % ChunkSize] = RecordedFrame{ static_cast<uint32_t>(frame), inputs };
+            size++;
+        }
+
+        return offset;
+    }
+
+    void Read(uint64_t offset, uint32_t length, M64Diff& m64Diff) const
+    {
+        for (uint64_t i = offset; i < offset + length; i++)
+        {
+            const RecordedFrame& recordedFrame = chunks[i / ChunkSize][i % ChunkSize];
+            m64Diff.frames[recordedFrame.frame] = recordedFrame.inputs;
+        }
+    }
+
+    uint64_t Size() const { return size; }
+
+private:
+    class RecordedFrame
+    {
+    public:
+        uint32_t frame = 0;
+        Inputs inputs;
+    };
+
+    static constexpr uint64_t ChunkSize = 1 << 16;
+
+    std::vector<std::unique_ptr<RecordedFrame[]>> chunks;
+    uint64_t size = 0;
+};
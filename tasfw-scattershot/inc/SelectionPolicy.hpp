@@ -0,0 +1,98 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// What a selection policy knows about a block
+class BlockSelectionStats
+{
+public:
+    float fitness = 0;
+    uint32_t nSelections = 0;
+    uint32_t nSuccesses = 0; // Selections whose shot found at least one new block
+};
+
+/// <summary>
+/// Decides how likely each block is to be picked as the base block of a shot.
+/// Weights are kept in a Fenwick tree and recomputed when a block is upserted or its selection statistics change.
+/// Solutions get no weight at all, so the policy is only asked about other blocks.
+/// </summary>
+class SelectionPolicy
+{
+public:
+    virtual ~SelectionPolicy() = default;
+
+    // Relative chance of the block being sampled. Must not be negative. Stored to 1/4096 and capped at 2^20, see FenwickTree.
+    virtual double GetWeight(const BlockSelectionStats& stats) const = 0;
+
+    // The fittest of this many samples is picked
+    virtual int GetTournamentSize() const { return 1; }
+};
+
+// Every block equally likely, as in the original scattershot
+class UniformSelection : public SelectionPolicy
+{
+public:
+    double GetWeight(const BlockSelectionStats&) const override { return 1; }
+};
+
+// Weight grows linearly with fitness above an offset, so fitness should be comparable across the run
+class FitnessProportionalSelection : public SelectionPolicy
+{
+public:
+    FitnessProportionalSelection(double fitnessOffset = 0, double minWeight = 1e-6) : fitnessOffset(fitnessOffset), minWeight(minWeight) {}
+
+    double GetWeight(const BlockSelectionStats& stats) const override
+    {
+        return std::max(stats.fitness - fitnessOffset, minWeight);
+    }
+
+private:
+    double fitnessOffset;
+    double minWeight; // Keeps the least fit blocks reachable
+};
+
+// Tournament selection, which favors blocks by fitness rank without having to keep every block's rank up to date
+class RankSelection : public SelectionPolicy
+{
+public:
+    RankSelection(int tournamentSize = 3) : tournamentSize(tournamentSize) {}
+
+    double GetWeight(const BlockSelectionStats&) const override { return 1; }
+    int GetTournamentSize() const override { return tournamentSize; }
+
+private:
+    int tournamentSize;
+};
+
+// Favors blocks that have rarely been shot from
+class NoveltySelection : public SelectionPolicy
+{
+public:
+    NoveltySelection(double exponent = 1) : exponent(exponent) {}
+
+    double GetWeight(const BlockSelectionStats& stats) const override
+    {
+        return std::pow(1.0 + stats.nSelections, -exponent);
+    }
+
+private:
+    double exponent;
+};
+
+// Upper confidence bound on how often a shot from the block finds a new block.
+// The log of the total selection count is left out, since it would change every block's weight on every shot.
+class UcbSelection : public SelectionPolicy
+{
+public:
+    UcbSelection(double exploration = 1) : exploration(exploration) {}
+
+    double GetWeight(const BlockSelectionStats& stats) const override
+    {
+        double successRate = (stats.nSuccesses + 1.0) / (stats.nSelections + 2.0);
+        return successRate + exploration / std::sqrt(stats.nSelections + 1.0);
+    }
+
+private:
+    double exploration;
+};
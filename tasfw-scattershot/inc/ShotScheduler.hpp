@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+class ShotTask
+{
+public:
+    uint64_t shot = 0; // Index of the shot in the run, which also orders its upserts
+    uint64_t seed = 0; // The shot's rng starts here, so what it finds doesn't depend on the worker that runs it
+};
+
+/// <summary>
+/// Hands out shots to workers, each holding one resource, through a deque per worker.
+/// Workers take from the front of their own deque and steal from the back of the others' once it is empty,
+/// so a worker stuck on an expensive shot doesn't hold up the shots that were dealt to it.
+/// There is one worker per resource for the whole run, so the workers themselves are fixed and only the shots move between them.
+/// Shots take milliseconds at least, so each deque has a plain lock instead of a lock-free protocol.
+/// </summary>
+class ShotScheduler
+{
+public:
+    ShotScheduler(int nWorkers) : nWorkers(nWorkers), workers(std::make_unique<WorkerQueue[]>(nWorkers)) {}
+
+    ShotScheduler(const ShotScheduler&) = delete;
+    ShotScheduler& operator= (const ShotScheduler&) = delete;
+
+    // Deal shots [firstShot, firstShot + nShots) round-robin over the workers
+    template <typename F>
+    void Deal(uint64_t firstShot, uint64_t nShots, F getSeed)
+    {
+        if (nWorkers <= 0)
+            throw std::runtime_error("No workers to deal shots to");
+
+        for (uint64_t shot = firstShot; shot < firstShot + nShots; shot++)
+        {
+            WorkerQueue& queue = workers[(shot - firstShot) % nWorkers];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(ShotTask{ shot, getSeed(shot) });
+        }
+    }
+
+    // Returns false once no worker has a shot left
+    bool Next(int worker, ShotTask& task)
+    {
+        if (Take(workers[worker], task, false))
+            return true;
+
+        // Start from a different worker each time so steals spread out
+        WorkerQueue& queue = workers[worker];
+        for (int i = 0; i < nWorkers; i++)
+        {
+            int victim = (queue.nextVictim + i) % nWorkers;
+            if (victim == worker || !Take(workers[victim], task, true))
+                continue;
+
+            queue.nextVictim = victim + 1;
+            nSteals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        return false;
+    }
+
+    uint64_t GetSteals() const
+    {
+        return nSteals.load(std::memory_order_relaxed);
+    }
+
+private:
+    class alignas(64) WorkerQueue
+    {
+    public:
+        std::mutex mutex;
+        std::deque<ShotTask> tasks;
+        int nextVictim = 0; // Only used by the worker itself
+    };
+
+    int nWorkers;
+    std::unique_ptr<WorkerQueue[]> workers;
+    std::atomic<uint64_t> nSteals = 0;
+
+    static bool Take(WorkerQueue& queue, ShotTask& task, bool steal)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            return false;
+
+        if (steal)
+        {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+
+        return true;
+    }
+};
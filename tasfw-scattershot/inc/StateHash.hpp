@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Finalizer that spreads every input bit over the whole hash (murmur3 fmix64)
+inline uint64_t MixHash(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+// Next state of a splitmix64 generator. Cheaper than hashing the state as bytes, and every seed gives a full period.
+inline uint64_t MixRng(uint64_t rngState)
+{
+    uint64_t value = rngState + 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+/// <summary>
+/// Which bytes of a state bin its equality depends on, as a mask over each 64-bit word of it.
+/// Filler bytes such as padding are found at runtime by changing each byte and comparing, once per type.
+/// </summary>
+template <class TState>
+class StateBinMask
+{
+public:
+    static constexpr std::size_t nWords = (sizeof(TState) + 7) / 8;
+
+    std::array<uint64_t, nWords> words{};
+
+    static const StateBinMask<TState>& Get()
+    {
+        static const StateBinMask<TState> mask;
+        return mask;
+    }
+
+private:
+    StateBinMask()
+    {
+        TState stateBin;
+        std::byte* binPtr = reinterpret_cast<std::byte*>(&stateBin);
+
+        // initialize to specific garbage data compatible with all primitives;
+        for (std::size_t i = 0; i < sizeof(TState); i++)
+            binPtr[i] = (std::byte)0x3f;
+
+        // Check which bytes identity depends on
+        TState stateBinCopy = stateBin;
+        auto* maskBytes = reinterpret_cast<unsigned char*>(words.data());
+        for (std::size_t i = 0; i < sizeof(TState); i++)
+        {
+            binPtr[i] = (std::byte)0x00;
+            if (!(stateBin == stateBinCopy))
+                maskBytes[i] = 0xff;
+            binPtr[i] = (std::byte)0x3f;
+        }
+    }
+};
+
+// Hash an object a word at a time, with optional per-word masks. Four independent lanes keep the multiplies pipelined,
+// and the fixed word count lets the compiler unroll and vectorize the loads and masking.
+template <typename T>
+uint64_t HashWords(const T& toHash, const uint64_t* mask = nullptr)
+{
+    constexpr std::size_t nWords = (sizeof(T) + 7) / 8;
+    std::array<uint64_t, nWords> words{};
+    std::memcpy(words.data(), &toHash, sizeof(T));
+
+    uint64_t lanes[4] = { 0x9e3779b97f4a7c15ull, 0xbf58476d1ce4e5b9ull, 0x94d049bb133111ebull, sizeof(T) };
+    for (std::size_t word = 0; word < nWords; word++)
+    {
+        uint64_t value = mask ? words[word] & mask[word] : words[word];
+        uint64_t& lane = lanes[word % 4];
+        lane = std::rotl(lane ^ (value * 0x87c37b91114253d5ull), 31) * 0x4cf5ad432745937full;
+    }
+
+    return MixHash(lanes[0] ^ std::rotl(lanes[1], 16) ^ std::rotl(lanes[2], 32) ^ std::rotl(lanes[3], 48));
+}
+
+// Hash a state bin, ignoring its filler bytes so equal state bins always hash the same
+template <class TState>
+uint64_t HashStateBin(const TState& stateBin)
+{
+    return HashWords(stateBin, StateBinMask<TState>::Get().words.data());
+}
@@ -0,0 +1,326 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+/*
+Binary columnar telemetry, one file per run. All integers are little-endian.
+
+    Header: "SSTEL001", uint32 column count, then per column a uint32 name length and the name
+    Blocks until the end of the file: uint32 row count, then per column
+        uint8 type, then the column's values for the block:
+        Int64 and Float64: 8 bytes per row
+        String: uint32 length per row, then the strings back to back
+
+Each block picks the narrowest type that fits all of a column's cells in it, so a column can change type between blocks.
+A block cut short, as when the run is still writing it, is ignored by readers.
+*/
+
+enum class TelemetryColumnType : uint8_t
+{
+    Int64 = 0,
+    Float64 = 1,
+    String = 2
+};
+
+inline constexpr char TelemetryMagic[8] = { 'S', 'S', 'T', 'E', 'L', '0', '0', '1' };
+
+/// <summary>
+/// Collects rows of text cells and writes them a block at a time, with each column stored as typed values.
+/// </summary>
+class TelemetryColumnarWriter
+{
+public:
+    bool Open(const std::filesystem::path& path, const std::vector<std::string>& columnNames)
+    {
+        file = std::ofstream(path, std::ios::binary);
+        columns = std::vector<std::vector<std::string>>(columnNames.size());
+
+        file.write(TelemetryMagic, sizeof(TelemetryMagic));
+        WriteValue(static_cast<uint32_t>(columnNames.size()));
+        for (const std::string& name : columnNames)
+        {
+            WriteValue(static_cast<uint32_t>(name.size()));
+            file.write(name.data(), name.size());
+        }
+
+        return !file.fail();
+    }
+
+    bool Good() const
+    {
+        return file.is_open() && !file.fail();
+    }
+
+    size_t GetColumnCount() const
+    {
+        return columns.size();
+    }
+
+    size_t GetPendingRows() const
+    {
+        return nPendingRows;
+    }
+
+    // Expects one cell per column
+    void AddRow(const std::vector<std::string_view>& cells)
+    {
+        for (size_t column = 0; column < columns.size(); column++)
+            columns[column].emplace_back(cells[column]);
+
+        nPendingRows++;
+    }
+
+    // Write the pending rows as one block
+    bool WriteBlock()
+    {
+        if (nPendingRows == 0)
+            return Good();
+
+        WriteValue(static_cast<uint32_t>(nPendingRows));
+        for (std::vector<std::string>& cells : columns)
+        {
+            TelemetryColumnType type = GetNarrowestType(cells);
+            WriteValue(static_cast<uint8_t>(type));
+            switch (type)
+            {
+            case TelemetryColumnType::Int64:
+                for (const std::string& cell : cells)
+                {
+                    int64_t value = 0;
+                    ParseInt(cell, value);
+                    WriteValue(value);
+                }
+                break;
+            case TelemetryColumnType::Float64:
+                for (const std::string& cell : cells)
+                {
+                    double value = 0;
+                    ParseFloat(cell, value);
+                    WriteValue(value);
+                }
+                break;
+            default:
+                for (const std::string& cell : cells)
+                    WriteValue(static_cast<uint32_t>(cell.size()));
+
+                for (const std::string& cell : cells)
+                    file.write(cell.data(), cell.size());
+            }
+
+            cells.clear();
+        }
+
+        nPendingRows = 0;
+        file.flush();
+        return Good();
+    }
+
+    static bool ParseInt(std::string_view text, int64_t& value)
+    {
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return !text.empty() && result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    static bool ParseFloat(std::string_view text, double& value)
+    {
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return !text.empty() && result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+private:
+    std::ofstream file;
+    std::vector<std::vector<std::string>> columns; // Pending cells, by column
+    size_t nPendingRows = 0;
+
+    template <typename T>
+    void WriteValue(T value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static TelemetryColumnType GetNarrowestType(const std::vector<std::string>& cells)
+    {
+        TelemetryColumnType type = TelemetryColumnType::Int64;
+        for (const std::string& cell : cells)
+        {
+            int64_t intValue = 0;
+            double floatValue = 0;
+            if (type == TelemetryColumnType::Int64 && ParseInt(cell, intValue))
+                continue;
+
+            if (!ParseFloat(cell, floatValue))
+                return TelemetryColumnType::String;
+
+            type = TelemetryColumnType::Float64;
+        }
+
+        return type;
+    }
+};
+
+class TelemetryColumn
+{
+public:
+    std::string name;
+    TelemetryColumnType type = TelemetryColumnType::Int64;
+    std::vector<int64_t> ints;
+    std::vector<double> floats;
+    std::vector<std::string> strings;
+
+    size_t Size() const
+    {
+        switch (type)
+        {
+        case TelemetryColumnType::Int64: return ints.size();
+        case TelemetryColumnType::Float64: return floats.size();
+        default: return strings.size();
+        }
+    }
+
+    std::string ToString(size_t row) const
+    {
+        char buffer[32];
+        switch (type)
+        {
+        case TelemetryColumnType::Int64:
+            return std::string(buffer, std::to_chars(buffer, buffer + sizeof(buffer), ints[row]).ptr);
+        case TelemetryColumnType::Float64:
+            return std::string(buffer, std::to_chars(buffer, buffer + sizeof(buffer), floats[row]).ptr);
+        default:
+            return strings[row];
+        }
+    }
+
+    // Convert the values read so far to a wider type
+    void Widen(TelemetryColumnType newType)
+    {
+        if (newType <= type)
+            return;
+
+        size_t nRows = Size();
+        if (newType == TelemetryColumnType::Float64)
+        {
+            for (int64_t value : ints)
+                floats.push_back(static_cast<double>(value));
+        }
+        else
+        {
+            for (size_t row = 0; row < nRows; row++)
+                strings.push_back(ToString(row));
+
+            floats.clear();
+        }
+
+        ints.clear();
+        type = newType;
+    }
+};
+
+/// <summary>
+/// Reads a whole telemetry file into columns, each widened to the widest type any of its blocks used.
+/// </summary>
+class TelemetryColumnarReader
+{
+public:
+    // Stops after maxRows, rounded up to a whole block. Returns false if the file is not telemetry.
+    static bool Read(const std::filesystem::path& path, std::vector<TelemetryColumn>& columns,
+        uint64_t maxRows = std::numeric_limits<uint64_t>::max())
+    {
+        std::ifstream file(path, std::ios::binary);
+        char magic[sizeof(TelemetryMagic)];
+        uint32_t nColumns = 0;
+        if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, TelemetryMagic, sizeof(magic)) != 0 || !ReadValue(file, nColumns))
+            return false;
+
+        columns = std::vector<TelemetryColumn>(nColumns);
+        for (TelemetryColumn& column : columns)
+        {
+            uint32_t nameLength = 0;
+            if (!ReadValue(file, nameLength))
+                return false;
+
+            column.name.resize(nameLength);
+            if (!file.read(column.name.data(), nameLength))
+                return false;
+        }
+
+        uint64_t nRows = 0;
+        std::vector<TelemetryColumn> block(nColumns);
+        while (nRows < maxRows && ReadBlock(file, block))
+        {
+            for (size_t column = 0; column < nColumns; column++)
+                Append(columns[column], block[column]);
+
+            nRows += block.empty() ? 0 : block[0].Size();
+        }
+
+        return true;
+    }
+
+private:
+    template <typename T>
+    static bool ReadValue(std::ifstream& file, T& value)
+    {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    static bool ReadBlock(std::ifstream& file, std::vector<TelemetryColumn>& block)
+    {
+        uint32_t nRows = 0;
+        if (!ReadValue(file, nRows))
+            return false;
+
+        for (TelemetryColumn& column : block)
+        {
+            uint8_t type = 0;
+            if (!ReadValue(file, type) || type > static_cast<uint8_t>(TelemetryColumnType::String))
+                return false;
+
+            column.type = static_cast<TelemetryColumnType>(type);
+            column.ints.resize(column.type == TelemetryColumnType::Int64 ? nRows : 0);
+            column.floats.resize(column.type == TelemetryColumnType::Float64 ? nRows : 0);
+            column.strings.resize(column.type == TelemetryColumnType::String ? nRows : 0);
+            if (column.type == TelemetryColumnType::Int64 && !file.read(reinterpret_cast<char*>(column.ints.data()), nRows * sizeof(int64_t)))
+                return false;
+
+            if (column.type == TelemetryColumnType::Float64 && !file.read(reinterpret_cast<char*>(column.floats.data()), nRows * sizeof(double)))
+                return false;
+
+            if (column.type == TelemetryColumnType::String)
+            {
+                std::vector<uint32_t> lengths(nRows);
+                if (!file.read(reinterpret_cast<char*>(lengths.data()), nRows * sizeof(uint32_t)))
+                    return false;
+
+                for (uint32_t row = 0; row < nRows; row++)
+                {
+                    column.strings[row].resize(lengths[row]);
+                    if (!file.read(column.strings[row].data(), lengths[row]))
+                        return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    static void Append(TelemetryColumn& column, TelemetryColumn& block)
+    {
+        TelemetryColumnType type = std::max(column.type, block.type);
+        column.Widen(type);
+        block.Widen(type);
+
+        column.ints.insert(column.ints.end(), block.ints.begin(), block.ints.end());
+        column.floats.insert(column.floats.end(), block.floats.begin(), block.floats.end());
+        column.strings.insert(column.strings.end(), block.strings.begin(), block.strings.end());
+    }
+};
@@ -0,0 +1,247 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <TelemetryFormat.hpp>
+
+class TelemetryRow
+{
+public:
+    int64_t shot = 0;
+    int64_t frame = 0;
+    bool sampled = false;
+    std::string cells; // The script's comma separated cells
+};
+
+/// <summary>
+/// Writes rows of scattershot telemetry on a background thread, as CSV and optionally in the binary columnar format.
+/// Each worker queues rows into its own single-producer ring buffer, so adding a row takes no lock.
+/// A worker only waits if its buffer is full, which means the writer can't keep up with the sample period.
+/// </summary>
+class TelemetrySink
+{
+public:
+    TelemetrySink(int nThreads, size_t bufferRows)
+        : nThreads(nThreads), buffers(std::make_unique<RowBuffer[]>(nThreads))
+    {
+        for (int thread = 0; thread < nThreads; thread++)
+        {
+            buffers[thread].capacity = std::max<size_t>(bufferRows, 1);
+            buffers[thread].rows = std::make_unique<TelemetryRow[]>(buffers[thread].capacity);
+        }
+    }
+
+    TelemetrySink(const TelemetrySink&) = delete;
+    TelemetrySink& operator= (const TelemetrySink&) = delete;
+
+    ~TelemetrySink()
+    {
+        Close();
+    }
+
+    // Write the column labels and start the writer. Leave binaryPath empty for CSV only.
+    bool Open(const std::filesystem::path& csvPath, const std::filesystem::path& binaryPath, const std::string& labels)
+    {
+        csv = std::ofstream(csvPath, std::ios::binary);
+        csv << labels << "\n";
+        if (csv.fail())
+            return false;
+
+        std::vector<std::string> columnNames;
+        for (std::string_view label : Split(labels, cellViews))
+            columnNames.emplace_back(label);
+
+        nColumns = columnNames.size();
+        if (!binaryPath.empty() && !columnar.Open(binaryPath, columnNames))
+            return false;
+
+        enabled.store(true, std::memory_order_release);
+        writer = std::thread([this]() { Write(); });
+        return true;
+    }
+
+    // Stops taking rows, then writes whatever is queued
+    void Close()
+    {
+        enabled.store(false, std::memory_order_release);
+        if (!writer.joinable())
+            return;
+
+        stopping.store(true, std::memory_order_release);
+        writer.join();
+    }
+
+    bool IsEnabled() const
+    {
+        return enabled.load(std::memory_order_acquire);
+    }
+
+    // Rows written and flushed, so readers of the files can stop there to skip partial rows
+    uint64_t GetRowsWritten() const
+    {
+        return nRowsWritten.load(std::memory_order_acquire);
+    }
+
+    // Returns false if the row has a different number of cells than there are labels.
+    // Each thread must only add rows to its own buffer.
+    bool Add(int thread, int64_t shot, int64_t frame, bool sampled, std::string cells)
+    {
+        if (static_cast<size_t>(std::count(cells.begin(), cells.end(), ',')) + 4 != nColumns)
+            return false;
+
+        RowBuffer& buffer = buffers[thread];
+        uint64_t tail = buffer.tail.load(std::memory_order_relaxed);
+        while (tail - buffer.head.load(std::memory_order_acquire) >= buffer.capacity)
+        {
+            if (!IsEnabled())
+                return true;
+
+            std::this_thread::yield();
+        }
+
+        TelemetryRow& row = buffer.rows[tail % buffer.capacity];
+        row.shot = shot;
+        row.frame = frame;
+        row.sampled = sampled;
+        row.cells = std::move(cells);
+        buffer.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static constexpr size_t RowsPerBlock = 4096;
+    static constexpr auto BlockInterval = std::chrono::seconds(1); // Partial blocks are written this often, so the file can be analyzed mid-run
+    static constexpr auto IdleInterval = std::chrono::milliseconds(5);
+
+    class alignas(64) RowBuffer
+    {
+    public:
+        std::unique_ptr<TelemetryRow[]> rows;
+        size_t capacity = 0;
+        alignas(64) std::atomic<uint64_t> head = 0; // Next row the writer takes
+        alignas(64) std::atomic<uint64_t> tail = 0; // Next row the worker fills
+    };
+
+    int nThreads;
+    std::unique_ptr<RowBuffer[]> buffers;
+    std::ofstream csv;
+    TelemetryColumnarWriter columnar;
+    size_t nColumns = 0;
+    std::atomic<bool> enabled = false;
+    std::atomic<bool> stopping = false;
+    std::atomic<uint64_t> nRowsWritten = 0;
+    std::thread writer;
+
+    // Writer thread state
+    std::string line;
+    std::vector<std::string_view> cellViews;
+
+    static const std::vector<std::string_view>& Split(std::string_view text, std::vector<std::string_view>& cells)
+    {
+        cells.clear();
+        size_t start = 0;
+        for (size_t comma = text.find(','); comma != std::string_view::npos; comma = text.find(',', start))
+        {
+            cells.push_back(text.substr(start, comma - start));
+            start = comma + 1;
+        }
+
+        cells.push_back(text.substr(start));
+        return cells;
+    }
+
+    void Write()
+    {
+        auto lastBlock = std::chrono::steady_clock::now();
+        bool failed = false;
+        while (true)
+        {
+            // Rows queued before stopping is seen are still written
+            bool stop = stopping.load(std::memory_order_acquire);
+            uint64_t nRows = failed ? Discard() : Drain();
+
+            auto now = std::chrono::steady_clock::now();
+            if (!failed && columnar.Good() && (columnar.GetPendingRows() >= RowsPerBlock || stop || now - lastBlock >= BlockInterval))
+            {
+                columnar.WriteBlock();
+                lastBlock = now;
+            }
+
+            if (!failed && nRows > 0)
+            {
+                csv.flush();
+                if (csv.fail())
+                {
+                    // Stop taking rows so the workers never wait on a writer that can't write
+                    std::cout << "Error writing telemetry to CSV. Disabling CSV export.\n";
+                    enabled.store(false, std::memory_order_release);
+                    failed = true;
+                }
+                else
+                    nRowsWritten.fetch_add(nRows, std::memory_order_release);
+            }
+
+            if (stop)
+                break;
+
+            if (nRows == 0)
+                std::this_thread::sleep_for(IdleInterval);
+        }
+
+        csv.close();
+    }
+
+    uint64_t Drain()
+    {
+        uint64_t nRows = 0;
+        for (int thread = 0; thread < nThreads; thread++)
+        {
+            RowBuffer& buffer = buffers[thread];
+            uint64_t head = buffer.head.load(std::memory_order_relaxed);
+            uint64_t tail = buffer.tail.load(std::memory_order_acquire);
+            for (; head != tail; head++)
+            {
+                TelemetryRow& row = buffer.rows[head % buffer.capacity];
+                line.clear();
+                line += std::to_string(row.shot);
+                line += ',';
+                line += std::to_string(row.frame);
+                line += row.sampled ? ",1," : ",0,";
+                line += row.cells;
+                line += '\n';
+                csv.write(line.data(), line.size());
+
+                if (columnar.Good())
+                {
+                    Split(std::string_view(line.data(), line.size() - 1), cellViews);
+                    columnar.AddRow(cellViews);
+                }
+
+                row.cells.clear();
+                nRows++;
+            }
+
+            buffer.head.store(tail, std::memory_order_release);
+        }
+
+        return nRows;
+    }
+
+    // Frees the buffers of workers that raced the writer failing
+    uint64_t Discard()
+    {
+        for (int thread = 0; thread < nThreads; thread++)
+            buffers[thread].head.store(buffers[thread].tail.load(std::memory_order_acquire), std::memory_order_release);
+
+        return 0;
+    }
+};
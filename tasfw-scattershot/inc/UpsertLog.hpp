@@ -0,0 +1,46 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// Upserts a thread made during an epoch of a deterministic run, held back until every thread has finished the epoch.
+/// Each entry is tagged with a logical timestamp, and committing all threads' logs in timestamp order
+/// gives the same blocks however the threads were scheduled, so threads don't have to wait on each other mid-epoch.
+/// </summary>
+class UpsertLog
+{
+public:
+    std::vector<uint32_t> pinnedSegments; // Segments the logged upserts refer to, held until they are committed
+
+    // Entries with the same sequence number are committed in the order they were logged
+    void Add(uint64_t sequence, std::function<void()> upsert)
+    {
+        entries.emplace_back(sequence, std::move(upsert));
+    }
+
+    // Commits every thread's entries by sequence number, ties going to the lower thread, and empties the logs
+    static void Commit(std::vector<UpsertLog>& logs)
+    {
+        std::vector<std::tuple<uint64_t, std::size_t, std::size_t>> order;
+        for (std::size_t thread = 0; thread < logs.size(); thread++)
+        {
+            for (std::size_t entry = 0; entry < logs[thread].entries.size(); entry++)
+                order.emplace_back(logs[thread].entries[entry].first, thread, entry);
+        }
+
+        std::sort(order.begin(), order.end());
+        for (const auto& [sequence, thread, entry] : order)
+            logs[thread].entries[entry].second();
+
+        for (UpsertLog& log : logs)
+            log.entries.clear();
+    }
+
+private:
+    std::vector<std::pair<uint64_t, std::function<void()>>> entries;
+};
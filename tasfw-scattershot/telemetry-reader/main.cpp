@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <TelemetryFormat.hpp>
+
+// Quote cells R's read.csv would otherwise split or misread
+static std::string QuoteCsv(const std::string& cell)
+{
+    if (cell.find_first_of(",\"\n") == std::string::npos)
+        return cell;
+
+    std::string quoted = "\"";
+    for (char c : cell)
+    {
+        if (c == '"')
+            quoted += '"';
+
+        quoted += c;
+    }
+
+    return quoted + "\"";
+}
+
+static const char* GetTypeName(TelemetryColumnType type)
+{
+    switch (type)
+    {
+    case TelemetryColumnType::Int64: return "int64";
+    case TelemetryColumnType::Float64: return "float64";
+    default: return "string";
+    }
+}
+
+// Usage: telemetry-reader <telemetry file> [output CSV] [max rows]
+// Without an output CSV, prints the columns and row count. The CSV can be read by analysis/print_scattershot_data.R.
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: telemetry-reader <telemetry file> [output CSV] [max rows]\n";
+        return 1;
+    }
+
+    uint64_t maxRows = argc > 3 ? std::stoull(argv[3]) : UINT64_MAX;
+    std::vector<TelemetryColumn> columns;
+    if (!TelemetryColumnarReader::Read(argv[1], columns, maxRows))
+    {
+        std::cout << "'" << argv[1] << "' is not a telemetry file.\n";
+        return 1;
+    }
+
+    uint64_t nRows = columns.empty() ? 0 : std::min<uint64_t>(columns[0].Size(), maxRows);
+    if (argc < 3)
+    {
+        for (const TelemetryColumn& column : columns)
+            std::cout << column.name << ": " << GetTypeName(column.type) << "\n";
+
+        std::cout << "Rows: " << nRows << "\n";
+        return 0;
+    }
+
+    std::ofstream csv(argv[2], std::ios::binary);
+    for (size_t column = 0; column < columns.size(); column++)
+        csv << (column == 0 ? "" : ",") << QuoteCsv(columns[column].name);
+
+    csv << "\n";
+    for (uint64_t row = 0; row < nRows; row++)
+    {
+        for (size_t column = 0; column < columns.size(); column++)
+            csv << (column == 0 ? "" : ",") << QuoteCsv(columns[column].ToString(row));
+
+        csv << "\n";
+    }
+
+    if (csv.fail())
+    {
+        std::cout << "Unable to write '" << argv[2] << "'.\n";
+        return 1;
+    }
+
+    std::cout << "Wrote " << nRows << " rows to '" << argv[2] << "'.\n";
+    return 0;
+}
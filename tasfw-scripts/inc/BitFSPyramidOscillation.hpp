@@ -18,6 +18,7 @@ public:
 	int16_t roughTargetAngle = 0;
 	bool optimizeMaxSpeed = false;
 	bool ignoreXzSum = false;
+	int64_t checkpointMemBudget = int64_t(1000) * 1024 * 1024; // Save memory for the checkpoints of each backward sweep
 };
 
 class BitFsPyramidOscillation : public Script<LibSm64>
@@ -186,14 +187,6 @@ public:
 	class CustomScriptStatus
 	{
 	public:
-		class FrameInputStatus
-		{
-		public:
-			bool isAngleDownhill = false;
-			bool isAngleOptimal = false;
-		};
-
-		std::map<uint64_t, FrameInputStatus> frameStatuses;
 		int64_t framePassedEquilibriumPoint = -1;
 		float maxSpeed = 0;
 		float passedEquilibriumSpeed = 0;
@@ -2,6 +2,7 @@
 #include <Scattershot.hpp>
 #include <BitFSPyramidOscillation.hpp>
 #include <cmath>
+#include <memory>
 #include <sm64/Camera.hpp>
 #include <sm64/Types.hpp>
 #include <sm64/Sm64.hpp>
@@ -59,6 +60,40 @@ public:
         float maxDownhillSpeed = 0;
     };
 
+    // Crossings so far on this timeline. Earlier crossings are immutable and shared by the states of later frames and
+    // of other branches, so carrying them over to the next frame is a pointer copy rather than a vector copy.
+    // The latest crossing is stored inline, since its max speed keeps updating until the next crossing.
+    class CrossingLog
+    {
+    public:
+        bool empty() const { return count == 0; }
+        int size() const { return count; }
+
+        const CrossingDto& back() const { return latest; }
+        CrossingDto& back() { return latest; }
+
+        // Walks back from the latest crossing, so this is only cheap for recent crossings. Throws if there is no such crossing.
+        const CrossingDto& operator[](int index) const { return FromBack(count - 1 - index); }
+        const CrossingDto& FromBack(int offset) const;
+
+        void push_back(const CrossingDto& crossing);
+
+        template <typename... Ts>
+        void emplace_back(Ts&&... params) { push_back(CrossingDto(std::forward<Ts>(params)...)); }
+
+    private:
+        class Node
+        {
+        public:
+            CrossingDto crossing;
+            std::shared_ptr<const Node> previous;
+        };
+
+        std::shared_ptr<const Node> previous;
+        CrossingDto latest;
+        int count = 0;
+    };
+
     class CustomScriptStatus
     {
     public:
@@ -72,7 +107,7 @@ public:
         float pyraNormY = 0;
         float pyraNormZ = 0;
         float xzSum = 0;
-        std::vector<CrossingDto> crossingData;
+        CrossingLog crossingData;
         int currentOscillation = 0;
         int currentCrossing = 0;
         bool reachedNormRegime = false;
@@ -100,6 +135,10 @@ public:
     bool execution();
     bool assertion();
 
+    // Streaming update from the previous frame's state
+    bool advance(const CustomScriptStatus& lastFrameState);
+    bool HasPreviousState();
+
 private:
     int16_t roughTargetAngleA = -24576;
     int16_t roughTargetAngleB = 8192;
@@ -108,8 +147,8 @@ private:
     int64_t initialFrame = 0;
 
     void SetStateVariables(MarioState* marioState, Object* pyramid);
-    void CalculateOscillations(CustomScriptStatus lastFrameState, MarioState* marioState, Object* pyramid);
-    void CalculatePhase(CustomScriptStatus lastFrameState, MarioState* marioState, Object* pyramid);
+    void CalculateOscillations(const CustomScriptStatus& lastFrameState, MarioState* marioState, Object* pyramid);
+    void CalculatePhase(const CustomScriptStatus& lastFrameState, MarioState* marioState, Object* pyramid);
 };
 
 using Alias_ScattershotThread_BitfsDr = ScattershotThread<BinaryStateBin<16>, LibSm64, StateTracker_BitfsDr, Scattershot_BitfsDr_Solution>;
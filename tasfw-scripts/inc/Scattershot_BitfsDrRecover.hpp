@@ -178,6 +178,20 @@ public:
     bool validation() { return GetCurrentFrame() >= initialFrame; }
 
     bool execution() 
+    {
+        int64_t currentFrame = GetCurrentFrame();
+        CustomScriptStatus lastFrameState = HasPreviousState()
+            ? GetTrackedState<StateTracker_BitfsDrRecover>(currentFrame - 1)
+            : CustomScriptStatus();
+
+        return advance(lastFrameState);
+    }
+
+    // The initial frame starts from the uninitialized state
+    bool HasPreviousState() { return GetCurrentFrame() > initialFrame; }
+
+    // Streaming update from the previous frame's state
+    bool advance(const CustomScriptStatus& lastFrameState)
     {
         MarioState* marioState = *(MarioState**)(resource->addr("gMarioState"));
         const BehaviorScript* pyramidBehavior = (const BehaviorScript*)(resource->addr("bhvLllTiltingInvertedPyramid"));
@@ -187,11 +201,6 @@ public:
         SetStateVariables(marioState, pyramid);
 
         // Calculate recursive metrics
-        int64_t currentFrame = GetCurrentFrame();
-        CustomScriptStatus lastFrameState;
-        if (currentFrame > initialFrame)
-            lastFrameState = GetTrackedState<StateTracker_BitfsDrRecover>(currentFrame - 1);
-
         if (!lastFrameState.initialized)
             return true;
 
@@ -300,7 +309,7 @@ private:
         CustomStatus.initialized = true;
     }
 
-    void CalculatePhase(CustomScriptStatus lastFrameState, MarioState* marioState, Object* pyramid)
+    void CalculatePhase(const CustomScriptStatus& lastFrameState, MarioState* marioState, Object* pyramid)
     {
         switch (lastFrameState.phase)
         {
@@ -52,6 +52,9 @@ bool BitFsPyramidOscillation_Iteration::execution()
 {
 	MarioState* marioState = (MarioState*) (resource->addr("gMarioStates"));
 
+	// Frames are loaded from last to first, so add checkpoints for a backward sweep on top of the cost-based saves
+	EnableCheckpointSchedule(_oscillationParams.checkpointMemBudget);
+
 	bool terminate = false;
 	bool foundResult = false;
 	auto turnRunStatus = ModifyCompareAdhoc<StatusField<BitFsPyramidOscillation_TurnThenRunDownhill>, std::tuple<int64_t>>(
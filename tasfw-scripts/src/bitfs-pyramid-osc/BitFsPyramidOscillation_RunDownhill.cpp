@@ -86,30 +86,6 @@ bool BitFsPyramidOscillation_RunDownhill::execution()
 			return true;
 		}
 
-		// Record whether downhill angle attempt was successful + optimal
-		CustomScriptStatus::FrameInputStatus frameStatus;
-
-		if (!status.asserted)
-			frameStatus.isAngleDownhill = false;
-		else if (marioState->faceAngle[1] == status.angleFacing)
-			frameStatus.isAngleDownhill = true;
-		else if (marioState->faceAngle[1] < status.angleFacing)
-			frameStatus.isAngleDownhill =
-				marioState->faceAngle[1] >= status.angleNotFacing;
-		else
-			frameStatus.isAngleDownhill =
-				marioState->faceAngle[1] <= status.angleNotFacing;
-
-		int32_t faceYawHau =
-			marioState->faceAngle[1] - (marioState->faceAngle[1] & 15);
-		int32_t angleFacingHau = status.angleFacing - (status.angleFacing & 15);
-		int32_t angleNotFacingHau =
-			status.angleNotFacing - (status.angleNotFacing & 15);
-		frameStatus.isAngleOptimal = frameStatus.isAngleDownhill &&
-			(faceYawHau == angleFacingHau || faceYawHau == angleNotFacingHau);
-
-		CustomStatus.frameStatuses[GetCurrentFrame() - 1] = frameStatus;
-
 		// Update max speed
 		if (marioState->forwardVel > CustomStatus.maxSpeed)
 			CustomStatus.maxSpeed = marioState->forwardVel;
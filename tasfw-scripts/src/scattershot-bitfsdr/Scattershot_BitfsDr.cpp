@@ -240,15 +240,15 @@ BinaryStateBin<16> Scattershot_BitfsDr::GetStateBin()
 
                 float nMajor = 0;
                 float nMinor = 0;
-                if (std::fabs(trackedState.crossingData.rbegin()->nZ) >= std::fabs(trackedState.crossingData.rbegin()->nX))
+                if (std::fabs(trackedState.crossingData.back().nZ) >= std::fabs(trackedState.crossingData.back().nX))
                 {
-                    nMajor = std::clamp(std::fabs(trackedState.crossingData.rbegin()->nZ), _normalSpecsDto.minMajor, _normalSpecsDto.maxMajor);
-                    nMinor = std::clamp(std::fabs(trackedState.crossingData.rbegin()->nX), _normalSpecsDto.minMinor, _normalSpecsDto.maxMinor);
+                    nMajor = std::clamp(std::fabs(trackedState.crossingData.back().nZ), _normalSpecsDto.minMajor, _normalSpecsDto.maxMajor);
+                    nMinor = std::clamp(std::fabs(trackedState.crossingData.back().nX), _normalSpecsDto.minMinor, _normalSpecsDto.maxMinor);
                 }
                 else
                 {
-                    nMajor = std::clamp(std::fabs(trackedState.crossingData.rbegin()->nX), _normalSpecsDto.minMajor, _normalSpecsDto.maxMajor);
-                    nMinor = std::clamp(std::fabs(trackedState.crossingData.rbegin()->nZ), _normalSpecsDto.minMinor, _normalSpecsDto.maxMinor);
+                    nMajor = std::clamp(std::fabs(trackedState.crossingData.back().nX), _normalSpecsDto.minMajor, _normalSpecsDto.maxMajor);
+                    nMinor = std::clamp(std::fabs(trackedState.crossingData.back().nZ), _normalSpecsDto.minMinor, _normalSpecsDto.maxMinor);
                 }
 
                 state.AddRegionBitsByNRegions(bitCursor, minimumBitsMajor, nMajor, _normalSpecsDto.minMajor, _normalSpecsDto.maxMajor, _normalSpecsDto.regionsMajor);
@@ -257,11 +257,11 @@ BinaryStateBin<16> Scattershot_BitfsDr::GetStateBin()
             else
             {
                 state.AddValueBits(bitCursor, 1, 0);
-                state.AddRegionBitsByRegionSize(bitCursor, 8, trackedState.crossingData.rbegin()->nZ, -0.7f, 0.7f, 0.005f);
-                state.AddRegionBitsByRegionSize(bitCursor, 8, trackedState.crossingData.rbegin()->nX, -0.7f, 0.7f, 0.005f);
+                state.AddRegionBitsByRegionSize(bitCursor, 8, trackedState.crossingData.back().nZ, -0.7f, 0.7f, 0.005f);
+                state.AddRegionBitsByRegionSize(bitCursor, 8, trackedState.crossingData.back().nX, -0.7f, 0.7f, 0.005f);
             }
 
-            int framesSinceCrossing = std::clamp(int(GetCurrentFrame() - trackedState.crossingData.rbegin()->frame), 0, 63);
+            int framesSinceCrossing = std::clamp(int(GetCurrentFrame() - trackedState.crossingData.back().frame), 0, 63);
             if (trackedState.phase == StateTracker_BitfsDr::Phase::RUN_DOWNHILL_PRE_CROSSING)
                 state.AddValueBits(bitCursor, 6, framesSinceCrossing);
         }
@@ -339,8 +339,8 @@ bool Scattershot_BitfsDr::ValidateState()
     // Validate major and minor horizontal norms are in correct windows
     if (state.currentOscillation >= _targetOscillation && !_normalSpecsDto.onlyMinMajor)
     {
-        float xNormCrossing = std::fabs(state.crossingData.rbegin()->nX);
-        float zNormCrossing = std::fabs(state.crossingData.rbegin()->nZ);
+        float xNormCrossing = std::fabs(state.crossingData.back().nX);
+        float zNormCrossing = std::fabs(state.crossingData.back().nZ);
 
         if (std::fabs(zNormCrossing) >= std::fabs(xNormCrossing))
         {
@@ -409,7 +409,7 @@ float Scattershot_BitfsDr::GetStateFitness()
             if (state.crossingData.empty())
                 return -float(GetCurrentFrame());
 
-            return float(state.crossingData.rbegin()->frame) - float(GetCurrentFrame());
+            return float(state.crossingData.back().frame) - float(GetCurrentFrame());
         }
     }
 
@@ -1,16 +1,41 @@
 #include <Scattershot_BitfsDr.hpp>
 
+const StateTracker_BitfsDr::CrossingDto& StateTracker_BitfsDr::CrossingLog::FromBack(int offset) const
+{
+    if (offset < 0 || offset >= count)
+        throw std::runtime_error("Crossing offset out of range");
+
+    if (offset == 0)
+        return latest;
+
+    const Node* node = previous.get();
+    for (int i = 1; i < offset; i++)
+        node = node->previous.get();
+
+    return node->crossing;
+}
+
+void StateTracker_BitfsDr::CrossingLog::push_back(const CrossingDto& crossing)
+{
+    // The latest crossing is final once another one comes along
+    if (count > 0)
+        previous = std::make_shared<const Node>(Node{ latest, std::move(previous) });
+
+    latest = crossing;
+    count++;
+}
+
 bool StateTracker_BitfsDr::ValidateCrossingData(const StateTracker_BitfsDr::CustomScriptStatus& state, float componentThreshold)
 {
     int crossings = state.crossingData.size();
     if (crossings > 2)
     {
-        auto lastCrossing0 = state.crossingData.rbegin();
-        auto lastCrossing2 = ++(++state.crossingData.rbegin());
-        if (lastCrossing0->speed <= lastCrossing2->speed || lastCrossing0->maxDownhillSpeed <= lastCrossing2->maxSpeed)
+        const CrossingDto& lastCrossing0 = state.crossingData.back();
+        const CrossingDto& lastCrossing2 = state.crossingData.FromBack(2);
+        if (lastCrossing0.speed <= lastCrossing2.speed || lastCrossing0.maxDownhillSpeed <= lastCrossing2.maxSpeed)
             return false;
 
-        if (std::fabs(lastCrossing0->nX) < componentThreshold && std::fabs(lastCrossing0->nZ) < componentThreshold)
+        if (std::fabs(lastCrossing0.nX) < componentThreshold && std::fabs(lastCrossing0.nZ) < componentThreshold)
             return false;
     }
 
@@ -20,6 +45,19 @@ bool StateTracker_BitfsDr::ValidateCrossingData(const StateTracker_BitfsDr::Cust
 bool StateTracker_BitfsDr::validation() { return GetCurrentFrame() >= initialFrame; }
 
 bool StateTracker_BitfsDr::execution()
+{
+    int64_t currentFrame = GetCurrentFrame();
+    CustomScriptStatus lastFrameState = HasPreviousState()
+        ? GetTrackedState<StateTracker_BitfsDr>(currentFrame - 1)
+        : CustomScriptStatus();
+
+    return advance(lastFrameState);
+}
+
+// The initial frame starts from the uninitialized state
+bool StateTracker_BitfsDr::HasPreviousState() { return GetCurrentFrame() > initialFrame; }
+
+bool StateTracker_BitfsDr::advance(const CustomScriptStatus& lastFrameState)
 {
     MarioState* marioState = *(MarioState**)(resource->addr("gMarioState"));
     const BehaviorScript* pyramidBehavior = (const BehaviorScript*)(resource->addr("bhvLllTiltingInvertedPyramid"));
@@ -29,11 +67,6 @@ bool StateTracker_BitfsDr::execution()
     SetStateVariables(marioState, pyramid);
 
     // Calculate recursive metrics
-    int64_t currentFrame = GetCurrentFrame();
-    CustomScriptStatus lastFrameState;
-    if (currentFrame > initialFrame)
-        lastFrameState = GetTrackedState<StateTracker_BitfsDr>(currentFrame - 1);
-
     if (!lastFrameState.initialized)
         return true;
 
@@ -70,7 +103,7 @@ void StateTracker_BitfsDr::SetStateVariables(MarioState* marioState, Object* pyr
     CustomStatus.initialized = true;
 }
 
-void StateTracker_BitfsDr::CalculateOscillations(CustomScriptStatus lastFrameState, MarioState* marioState, Object* pyramid)
+void StateTracker_BitfsDr::CalculateOscillations(const CustomScriptStatus& lastFrameState, MarioState* marioState, Object* pyramid)
 {
     if (CustomStatus.phase == Phase::INITIAL)
         return;
@@ -144,17 +177,17 @@ void StateTracker_BitfsDr::CalculateOscillations(CustomScriptStatus lastFrameSta
         if (!lastFrameState.crossingData.empty())
         {
             // Get number of frames since last crossing
-            int64_t lastCrossing = lastFrameState.crossingData.rbegin()->frame;
+            int64_t lastCrossing = lastFrameState.crossingData.back().frame;
 
             if (GetCurrentFrame() - lastCrossing >= minOscillationFrames)
                 CustomStatus.currentOscillation++;
         }
     }
-    else if (!CustomStatus.crossingData.empty() && marioState->forwardVel > CustomStatus.crossingData.rbegin()->maxSpeed)
-        CustomStatus.crossingData.rbegin()->maxSpeed = marioState->forwardVel;
+    else if (!CustomStatus.crossingData.empty() && marioState->forwardVel > CustomStatus.crossingData.back().maxSpeed)
+        CustomStatus.crossingData.back().maxSpeed = marioState->forwardVel;
 }
 
-void StateTracker_BitfsDr::CalculatePhase(CustomScriptStatus lastFrameState, MarioState* marioState, Object* pyramid)
+void StateTracker_BitfsDr::CalculatePhase(const CustomScriptStatus& lastFrameState, MarioState* marioState, Object* pyramid)
 {
     int32_t targetAngleDiffA = abs(int16_t(roughTargetAngleA - marioState->faceAngle[1]));
     int32_t targetAngleDiffB = abs(int16_t(roughTargetAngleB - marioState->faceAngle[1]));